@@ -10,8 +10,19 @@
 #include "qtutils.h"
 #include <util/platform.h>
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QFileInfo>
 #include <QtCore/QString>
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "CarlaBackendUtils.hpp"
 #include "CarlaBinaryUtils.hpp"
@@ -20,6 +31,45 @@
 // generates a warning if this is defined as anything else
 #define CARLA_API
 
+// current state format version
+// version 1 stores the chunk as plain base64 and custom data values as-is
+// version 2 compresses the chunk and big custom data values before encoding
+#define CARLA_STATE_VERSION 2
+
+// custom data values bigger than this are stored compressed
+#define CARLA_STATE_COMPRESS_THRESHOLD 4096
+
+// automatic restart of crashed bridges
+// first restart is immediate, then delay doubles up to the maximum
+// crash count is reset after the plugin runs without crashing for a while
+#define CARLA_RECOVERY_MAX_ATTEMPTS 5
+#define CARLA_RECOVERY_MIN_DELAY_NS 250000000ULL // 250ms
+#define CARLA_RECOVERY_MAX_DELAY_NS 2000000000ULL // 2s
+#define CARLA_RECOVERY_STABLE_NS 60000000000ULL // 60s
+
+// fade from dry to processed audio after a restart
+#define CARLA_RECOVERY_FADE_MS 20
+
+// equal-power crossfade between the old and new plugin when switching plugins
+// the switch is forced if audio does not flow for a while (e.g. source muted)
+#define CARLA_SWAP_FADE_MS 30
+#define CARLA_SWAP_TIMEOUT_NS 1000000000ULL // 1s
+
+// ----------------------------------------------------------------------------
+// state encoding helpers
+
+static QByteArray encode_state_data(const char *data, size_t size)
+{
+	return qCompress(reinterpret_cast<const uchar *>(data),
+			 static_cast<int>(size))
+		.toBase64();
+}
+
+static QByteArray decode_state_data(const char *b64data)
+{
+	return qUncompress(QByteArray::fromBase64(b64data));
+}
+
 // ----------------------------------------------------------------------------
 // private data methods
 
@@ -31,35 +81,349 @@ struct carla_priv : carla_bridge_callback {
 	// update properties when timeout is reached, 0 means do nothing
 	uint64_t update_request = 0;
 
-	carla_bridge bridge;
+	// cached encoded chunk, valid while `bridge.chunkDirty` is false
+	QByteArray encodedChunk;
+
+	// two bridge slots, so that a new plugin can be started while the
+	// current one keeps processing, see `carla_priv_replace_plugin`
+	// `bridge` is the current plugin, only changed from the UI thread
+	carla_bridge slots[2];
+	carla_bridge *bridge = &slots[0];
+
+	// hot-swap state
+	// the audio thread crossfades from `audioBridge` to `fadeInBridge`,
+	// then takes it as `audioBridge`, after which `retiredBridge` (the
+	// previous plugin) can be cleaned up
+	std::atomic<carla_bridge *> audioBridge{nullptr};
+	std::atomic<carla_bridge *> fadeInBridge{nullptr};
+	carla_bridge *retiredBridge = nullptr;
+	uint64_t swapStartTime = 0;
+	std::atomic<bool> swapPending{false};
+	std::atomic<bool> audioBusy{false};
+
+	// bridges being stopped in the background, see `carla_priv_teardown`
+	// `teardownFinish` runs once collected, releasing them for reuse
+	std::thread teardownThread;
+	std::atomic<bool> teardownDone{false};
+	std::function<void()> teardownFinish;
+
+	// state snapshots, see `carla_priv_recall_snapshot`
+	// the spare slot is prepared in the background with the state of
+	// `standbyName`, then kept running until recalled
+	std::thread standbyThread;
+	std::atomic<bool> standbyDone{false};
+	std::atomic<bool> standbyOk{false};
+	carla_bridge *standbyBridge = nullptr;
+	CarlaString standbyName;
+	CarlaString recallName;
+
+	// snapshot requests from other threads, handled during idle
+	// `snapshotNames` mirrors `PROP_SNAPSHOTS`, so that a recall can be
+	// checked without touching the settings
+	std::mutex snapshotMutex;
+	std::vector<CarlaString> snapshotNames;
+	CarlaString preloadRequest;
+	CarlaString recallRequest;
+	bool standbyOutdated = false;
+
+	// per-channel instances for mono plugins
+	// see `carla_priv_set_per_channel`
+	// plane 0 goes through `bridge`, plane N through `channelBridges[N-1]`
+	// the audio thread only uses the first `numChannelBridges` of them,
+	// and only together with `channelOwner`, whose state they follow
+	uint32_t perChannel = 0;
+	std::vector<std::unique_ptr<carla_bridge>> channelBridges;
+	std::atomic<uint32_t> numChannelBridges{0};
+	std::atomic<carla_bridge *> channelOwner{nullptr};
+	std::thread channelThread;
+	std::atomic<bool> channelDone{false};
+	std::atomic<bool> channelOk{false};
+	uint32_t channelCount = 0;
+	bool channelsFailed = false;
+
+	// instances to stop on the teardown thread, see
+	// `carla_priv_release_channels`
+	bool channelsRelease = false;
+
+	// bridge asked to report its state before starting instances
+	carla_bridge *channelSaveBridge = nullptr;
+
+	// serializes everything touching `bridge`, except for the audio thread
+	// UI side functions lock it, idle only tries and skips a pass if busy
+	// a background start owns the bridge while `starting` is set, only idle
+	// begins one and UI side functions wait for it while holding the lock
+	// recursive, as nested event loops on Windows can re-enter UI callbacks
+	std::recursive_mutex bridgeMutex;
+
+	// [de]activation and deferred start requested while `bridgeMutex` was
+	// busy, applied during idle
+	std::atomic<bool> activePending{false};
+	std::atomic<bool> startPending{false};
+
+	// bridge start in the background, for loading state and crash recovery
+	// audio and idle skip the bridge while `starting` is set
+	std::thread startThread;
+	std::atomic<bool> starting{false};
+	std::atomic<bool> startDone{false};
+	std::atomic<bool> fadePending{false};
+	std::atomic<bool> activeRequested{false};
+	bool settingsSyncPending = false;
+
+	// plugin loaded from saved state but not started yet, see `PROP_LAZY_START`
+	// custom data and chunk are already cached in the bridge
+	struct {
+		bool pending = false;
+		BinaryType btype = BINARY_NONE;
+		PluginType ptype = PLUGIN_NONE;
+		CarlaString label;
+		CarlaString filename;
+	} deferred;
+
+	// crash recovery
+	uint32_t crashCount = 0;
+	uint64_t lastCrashTime = 0;
+	uint64_t recoveryTime = 0; // 0 means no recovery scheduled
+
+	// fade-in state, only used in the audio thread
+	uint32_t fadePos = 0;
+	uint32_t fadeLength = 0;
+	float dryBuffers[MAX_AV_PLANES][MAX_AUDIO_BUFFER_SIZE];
+
+	// hot-swap crossfade state, only used in the audio thread
+	uint32_t swapPos = 0;
+	uint32_t swapLength = 0;
+	float swapBuffers[MAX_AV_PLANES][MAX_AUDIO_BUFFER_SIZE];
+
+	// receives the planes a per-channel instance does not use
+	float scratchBuffer[MAX_AUDIO_BUFFER_SIZE];
+
+	// currently visible page of parameters
+	uint32_t paramPage = 0;
+
+	// parameter layout and plugin hints the properties were last built from
+	carla_param_cache publishedParams;
+	bool publishedCustomUI = false;
+
+	// parameters changed by the plugin during the current idle pass
+	// latest values are in `bridge.params`, applied once per idle
+	std::vector<uint32_t> changedParams;
+	std::vector<bool> changedParamFlags;
+
+	// last known output parameters, see `carla_priv_get_output_params`
+	std::vector<uint32_t> outputIndices;
+	std::vector<float> outputValues;
 
 	void bridge_parameter_changed(uint index, float value) override
 	{
-		char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
-		param_index_to_name(index, pname);
-
-		// obs_source_t *source = priv->source;
-		obs_data_t *settings = obs_source_get_settings(source);
-
-		/**/ if (bridge.paramDetails[index].hints &
-			 PARAMETER_IS_BOOLEAN)
-			obs_data_set_bool(settings, pname,
-					  value > 0.5f ? 1.f : 0.f);
-		else if (bridge.paramDetails[index].hints &
-			 PARAMETER_IS_INTEGER)
-			obs_data_set_int(settings, pname, value);
-		else
-			obs_data_set_double(settings, pname, value);
+		UNUSED_PARAMETER(value);
 
-		obs_data_release(settings);
+		if (changedParamFlags.size() < bridge->params.count)
+			changedParamFlags.resize(bridge->params.count);
+
+		if (changedParamFlags[index])
+			return;
+
+		changedParamFlags[index] = true;
+		changedParams.push_back(index);
+	}
+};
+
+// ----------------------------------------------------------------------------
+// store current parameter value in OBS settings
+// returns false if settings already had the same value
+
+static bool param_value_to_settings(const carla_param_cache &params,
+				    obs_data_t *settings, uint32_t index)
+{
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+	param_index_to_name(index, pname);
+
+	const uint32_t hints = params.hints[index];
+	const float value = params.values[index];
+	const bool hasValue = obs_data_has_user_value(settings, pname);
+
+	if (hints & PARAMETER_IS_BOOLEAN) {
+		const bool bvalue = carla_isEqual(value, params.maxs[index]);
+		if (hasValue && obs_data_get_bool(settings, pname) == bvalue)
+			return false;
+		obs_data_set_bool(settings, pname, bvalue);
+	} else if (hints & PARAMETER_IS_INTEGER) {
+		const long long ivalue = value;
+		if (hasValue && obs_data_get_int(settings, pname) == ivalue)
+			return false;
+		obs_data_set_int(settings, pname, ivalue);
+	} else {
+		if (hasValue &&
+		    carla_isEqual(obs_data_get_double(settings, pname),
+				  static_cast<double>(value)))
+			return false;
+		obs_data_set_double(settings, pname, value);
+	}
+
+	return true;
+}
 
-		postpone_update_request(&update_request);
+// store all current parameter values of the plugin in OBS settings
+static void carla_priv_params_to_settings(struct carla_priv *priv)
+{
+	const carla_param_cache &params(priv->bridge->params);
+	obs_data_t *settings = obs_source_get_settings(priv->source);
+
+	for (uint32_t i = 0; i < params.count; ++i) {
+		if (params.is_input(i))
+			param_value_to_settings(params, settings, i);
 	}
+
+	obs_data_release(settings);
+}
+
+// ----------------------------------------------------------------------------
+// parameter layout comparison, used to avoid rebuilding properties
+
+enum param_prop_kind {
+	PARAM_PROP_NONE,
+	PARAM_PROP_OUTPUT,
+	PARAM_PROP_BOOL,
+	PARAM_PROP_INT,
+	PARAM_PROP_FLOAT,
 };
 
+static param_prop_kind get_param_prop_kind(const carla_param_cache &params,
+					   uint32_t index)
+{
+	const uint32_t hints = params.hints[index];
+
+	if ((hints & PARAMETER_IS_ENABLED) == 0)
+		return PARAM_PROP_NONE;
+	if (params.outputs[index])
+		return PARAM_PROP_OUTPUT;
+	if (hints & PARAMETER_IS_BOOLEAN)
+		return PARAM_PROP_BOOL;
+	if (hints & PARAMETER_IS_INTEGER)
+		return PARAM_PROP_INT;
+	return PARAM_PROP_FLOAT;
+}
+
+static bool param_layout_equal(const carla_param_cache &a,
+			       const carla_param_cache &b, uint32_t index)
+{
+	return a.hints[index] == b.hints[index] &&
+	       a.outputs[index] == b.outputs[index] &&
+	       carla_isEqual(a.defs[index], b.defs[index]) &&
+	       carla_isEqual(a.mins[index], b.mins[index]) &&
+	       carla_isEqual(a.maxs[index], b.maxs[index]) &&
+	       carla_isEqual(a.steps[index], b.steps[index]) &&
+	       std::strcmp(a.get_name(index), b.get_name(index)) == 0 &&
+	       std::strcmp(a.get_unit(index), b.get_unit(index)) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// plugin state as written by `carla_priv_save`
+
+// cache custom data and chunk in the bridge, sent once it is running
+// `encodedChunk` receives the chunk if it can be reused as-is, can be null
+static void cache_plugin_state(carla_bridge &bridge, obs_data_t *settings,
+			       QByteArray *encodedChunk)
+{
+	const int64_t version = obs_data_get_int(settings, "state-version");
+
+	obs_data_array_t *array =
+		obs_data_get_array(settings, PROP_CUSTOM_DATA);
+	if (array) {
+		const size_t count = obs_data_array_count(array);
+		for (size_t i = 0; i < count; ++i) {
+			obs_data_t *data = obs_data_array_item(array, i);
+			const char *type = obs_data_get_string(data, "type");
+			const char *key = obs_data_get_string(data, "key");
+			const char *value = obs_data_get_string(data, "value");
+
+			if (obs_data_get_bool(data, "compressed")) {
+				const QByteArray decoded(
+					decode_state_data(value));
+				bridge.add_custom_data(type, key,
+						       decoded.constData(),
+						       false);
+			} else {
+				bridge.add_custom_data(type, key, value, false);
+			}
+
+			obs_data_release(data);
+		}
+		obs_data_array_release(array);
+	}
+
+	// only used if the plugin turns out to use chunks
+	const char *b64chunk = obs_data_get_string(settings, PROP_CHUNK);
+
+	if (b64chunk != nullptr && b64chunk[0] != '\0') {
+		if (version >= 2) {
+			bridge.chunk = decode_state_data(b64chunk);
+			bridge.chunkDirty = true;
+
+			// what we just loaded is already in encoded form
+			if (encodedChunk != nullptr) {
+				*encodedChunk = b64chunk;
+				bridge.chunkDirty = false;
+			}
+		} else {
+			bridge.chunk = QByteArray::fromBase64(b64chunk);
+			bridge.chunkDirty = true;
+		}
+	}
+}
+
+// parameter values are only stored for plugins without chunks
+static void apply_state_params(carla_bridge &bridge, obs_data_t *settings)
+{
+	if (bridge.info.options & PLUGIN_OPTION_USE_CHUNKS)
+		return;
+
+	const carla_param_cache &params(bridge.params);
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+
+	for (uint32_t i = 0; i < params.count; ++i) {
+		const param_prop_kind kind = get_param_prop_kind(params, i);
+
+		if (kind == PARAM_PROP_NONE || kind == PARAM_PROP_OUTPUT)
+			continue;
+
+		param_index_to_name(i, pname);
+
+		if (!obs_data_has_user_value(settings, pname))
+			continue;
+
+		float value;
+		switch (kind) {
+		case PARAM_PROP_BOOL:
+			value = obs_data_get_bool(settings, pname)
+					? params.maxs[i]
+					: params.mins[i];
+			break;
+		case PARAM_PROP_INT:
+			value = obs_data_get_int(settings, pname);
+			break;
+		default:
+			value = obs_data_get_double(settings, pname);
+			break;
+		}
+
+		bridge.set_value(i, value);
+	}
+}
+
 // ----------------------------------------------------------------------------
 // carla + obs integration methods
 
+void carla_priv_module_load(void)
+{
+	carla_bridge_module_load();
+}
+
+void carla_priv_module_unload(void)
+{
+	carla_bridge_module_unload();
+}
+
 struct carla_priv *carla_priv_create(obs_source_t *source,
 				     enum buffer_size_mode bufsize,
 				     uint32_t srate)
@@ -68,7 +432,8 @@ struct carla_priv *carla_priv_create(obs_source_t *source,
 	if (priv == NULL)
 		return NULL;
 
-	priv->bridge.callback = priv;
+	priv->slots[0].callback = priv;
+	priv->audioBridge = priv->bridge;
 	priv->source = source;
 	priv->bufferSize = bufsize_mode_to_frames(bufsize);
 	priv->sampleRate = srate;
@@ -77,6 +442,8 @@ struct carla_priv *carla_priv_create(obs_source_t *source,
 	if (priv->bufferSize == 0)
 		goto fail1;
 
+	// shared memory channels are created on the first bridge start,
+	// sources with lazy start might never need them
 	return priv;
 
 fail1:
@@ -84,35 +451,1247 @@ fail1:
 	return nullptr;
 }
 
+// ----------------------------------------------------------------------------
+// background bridge start
+// many sources can start at once (e.g. scene collection load), but starting
+// too many bridges at the same time only slows all of them down
+
+static std::mutex s_start_mutex;
+static std::condition_variable s_start_cond;
+static uint s_start_count = 0;
+
+static uint get_max_parallel_starts()
+{
+	return std::max(4u, std::thread::hardware_concurrency());
+}
+
+// run `func` once there is room for another bridge start
+static void run_with_start_limit(const std::function<void()> &func)
+{
+	{
+		std::unique_lock<std::mutex> lock(s_start_mutex);
+		s_start_cond.wait(lock, []() {
+			return s_start_count < get_max_parallel_starts();
+		});
+		++s_start_count;
+	}
+
+	func();
+
+	{
+		const std::lock_guard<std::mutex> lock(s_start_mutex);
+		--s_start_count;
+	}
+	s_start_cond.notify_one();
+}
+
+// join a thread that might be starting a bridge process
+// Windows bridges are started on the main thread, which is kept responsive
+// meanwhile; a nested call from its event loop may join the thread first,
+// or even start a new one, so ownership is checked again on every pass
+// returns false if there was nothing left to join
+static bool join_bridge_thread(std::thread &thread,
+			       const std::atomic<bool> &done)
+{
+#ifdef _WIN32
+	if (QThread::currentThread() == qApp->thread()) {
+		while (thread.joinable() && !done) {
+			QCoreApplication::processEvents();
+			carla_msleep(1);
+		}
+	}
+#else
+	UNUSED_PARAMETER(done);
+#endif
+
+	if (!thread.joinable())
+		return false;
+
+	thread.join();
+	return true;
+}
+
+static void carla_priv_start_in_background(struct carla_priv *priv,
+					   std::function<void()> func)
+{
+	priv->starting = true;
+	priv->startDone = false;
+	priv->startThread = std::thread([priv, func]() {
+		run_with_start_limit(func);
+		priv->startDone = true;
+	});
+}
+
+// wait for a background start to finish
+// must be called before touching the bridge from outside the idle thread
+static void carla_priv_wait_start(struct carla_priv *priv)
+{
+	if (!join_bridge_thread(priv->startThread, priv->startDone))
+		return;
+
+	priv->starting = false;
+	priv->startDone = false;
+
+	// OBS might have [de]activated us in the mean time
+	if (priv->activeRequested != priv->bridge->is_active()) {
+		if (priv->activeRequested)
+			priv->bridge->activate();
+		else
+			priv->bridge->deactivate();
+	}
+}
+
+// ----------------------------------------------------------------------------
+// background teardown
+// stopping a bridge process can take seconds, idle hands it to a thread
+// only one teardown runs at a time, the caller retries later if busy
+
+// run `work` once the audio thread is done with the current block
+// returns false if another teardown is still running
+static bool carla_priv_teardown(struct carla_priv *priv,
+				std::function<void()> work,
+				std::function<void()> finish)
+{
+	if (priv->teardownThread.joinable())
+		return false;
+
+	priv->teardownFinish = std::move(finish);
+	priv->teardownDone = false;
+	priv->teardownThread = std::thread([priv, work]() {
+		// audio thread might still be in the block that last used them
+		while (priv->audioBusy)
+			carla_msleep(1);
+
+		work();
+		priv->teardownDone = true;
+	});
+
+	return true;
+}
+
+// run `finish` of a completed teardown, waiting for it if `wait` is set
+// returns false while a teardown is still running
+static bool carla_priv_collect_teardown(struct carla_priv *priv, bool wait)
+{
+	if (!priv->teardownThread.joinable())
+		return true;
+
+	if (!wait && !priv->teardownDone)
+		return false;
+
+	priv->teardownThread.join();
+
+	std::function<void()> finish;
+	finish.swap(priv->teardownFinish);
+	finish();
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// plugin hot-swap
+// a newly selected plugin is started on the spare slot while the current one
+// keeps processing, the audio thread then crossfades from one to the other
+
+// stop the previous plugin in the background once the crossfade is done,
+// its slot stays reserved until then
+// with `force` the switch happens right away, after giving the crossfade a
+// moment to finish, and any teardown is waited for; used from the UI side
+// before changing anything the audio thread relies on, idle never waits
+static void carla_priv_finish_swap(struct carla_priv *priv, bool force)
+{
+	if (force)
+		carla_priv_collect_teardown(priv, true);
+
+	if (priv->retiredBridge == nullptr || priv->teardownThread.joinable())
+		return;
+
+	if (priv->fadeInBridge != nullptr) {
+		if (!force && os_gettime_ns() - priv->swapStartTime <
+				      CARLA_SWAP_TIMEOUT_NS)
+			return;
+
+		if (force) {
+			for (int i = 0; i < 100 && priv->fadeInBridge != nullptr;
+			     ++i)
+				carla_msleep(1);
+		}
+
+		// audio is not flowing, switch without crossfade
+		carla_bridge *const next = priv->fadeInBridge.exchange(nullptr);
+		if (next != nullptr)
+			priv->audioBridge = next;
+	}
+
+	carla_bridge *const retired = priv->retiredBridge;
+
+	carla_priv_teardown(
+		priv, [retired]() { retired->cleanup(true, true); },
+		[priv]() { priv->retiredBridge = nullptr; });
+
+	if (force)
+		carla_priv_collect_teardown(priv, true);
+}
+
+// get the slot not used by the current plugin
+static carla_bridge *carla_priv_get_spare(struct carla_priv *priv)
+{
+	return priv->bridge == &priv->slots[0] ? &priv->slots[1]
+					       : &priv->slots[0];
+}
+
+// get the spare slot, ready for `start()`
+// must not be in use by a plugin switch or snapshot
+// parameter changes are only reported once it becomes the current plugin,
+// `changedParamFlags` follows the parameters of `bridge`
+static carla_bridge *carla_priv_prepare_spare(struct carla_priv *priv)
+{
+	carla_bridge *const current = priv->bridge;
+	carla_bridge *const spare = carla_priv_get_spare(priv);
+
+	spare->callback = nullptr;
+	spare->policy = current->policy;
+	spare->init(priv->bufferSize, priv->sampleRate);
+	spare->set_pipelined(current->is_pipelined());
+	return spare;
+}
+
+// make `next` the current plugin, crossfading to it in the audio thread
+static void carla_priv_start_swap(struct carla_priv *priv,
+				  carla_bridge *next)
+{
+	priv->bridge->callback = nullptr;
+	next->callback = priv;
+
+	priv->retiredBridge = priv->bridge;
+	priv->bridge = next;
+	priv->swapStartTime = os_gettime_ns();
+	priv->swapPending = true;
+	priv->fadeInBridge = next;
+}
+
+// replace the current plugin with a new one
+// while audio is flowing through a running plugin, the new one is started
+// on the spare slot and the current one is kept if that fails
+static bool carla_priv_replace_plugin(struct carla_priv *priv,
+				      BinaryType btype, PluginType ptype,
+				      const char *label, const char *filename,
+				      int64_t uniqueId)
+{
+	carla_bridge *const current = priv->bridge;
+
+	if (!priv->activeRequested || !current->is_active() ||
+	    !current->is_running()) {
+		current->cleanup(true, true);
+		current->init(priv->bufferSize, priv->sampleRate);
+
+		if (!current->start(btype, ptype, label, filename, uniqueId))
+			return false;
+
+		current->activate();
+		return true;
+	}
+
+	carla_bridge *const next = carla_priv_prepare_spare(priv);
+
+	if (!next->start(btype, ptype, label, filename, uniqueId)) {
+		next->cleanup(true, true);
+		return false;
+	}
+
+	next->activate();
+
+	carla_priv_start_swap(priv, next);
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// per-channel instances
+// a mono plugin only processes the first plane, so every other channel gets
+// its own instance of the same plugin with the same state and parameters
+// each one runs in its own bridge process, all of them working at once
+
+static bool carla_priv_wants_channels(struct carla_priv *priv)
+{
+	const carla_bridge &bridge(*priv->bridge);
+
+	return priv->perChannel > 1 && bridge.is_running() &&
+	       bridge.info.numAudioIns == 1 && bridge.info.numAudioOuts == 1;
+}
+
+// stop all instances, waiting for them, used from the UI side
+static void carla_priv_drop_channels(struct carla_priv *priv)
+{
+	join_bridge_thread(priv->channelThread, priv->channelDone);
+
+	// instances might be stopping on the teardown thread
+	carla_priv_collect_teardown(priv, true);
+
+	priv->channelsRelease = false;
+	priv->channelSaveBridge = nullptr;
+
+	// audio thread might still be in the middle of a block
+	priv->numChannelBridges = 0;
+
+	while (priv->audioBusy)
+		carla_msleep(1);
+
+	for (const std::unique_ptr<carla_bridge> &bridge :
+	     priv->channelBridges)
+		bridge->cleanup(true, true);
+}
+
+// same as `carla_priv_drop_channels` without waiting, the audio thread
+// stops using them from the next block on
+// they are stopped on the teardown thread during idle, once any start is done
+static void carla_priv_release_channels(struct carla_priv *priv)
+{
+	priv->numChannelBridges = 0;
+	priv->channelsRelease = true;
+}
+
+// start instances for all channels after the first in the background,
+// with the current state of the plugin
+static void carla_priv_start_channels(struct carla_priv *priv)
+{
+	carla_bridge &main(*priv->bridge);
+	const uint32_t count = priv->perChannel - 1;
+
+	while (priv->channelBridges.size() < count)
+		priv->channelBridges.emplace_back(new carla_bridge);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		carla_bridge &bridge(*priv->channelBridges[i]);
+
+		// parameter changes are taken from the main instance only
+		bridge.callback = nullptr;
+		bridge.policy = main.policy;
+
+		for (uint32_t j = 0, n = main.customData.count(); j < n; ++j) {
+			const carla_custom_data_store::item cdata(
+				main.customData.get(j));
+			bridge.add_custom_data(cdata.type, cdata.key,
+					       cdata.value, false);
+		}
+
+		bridge.chunk = main.chunk;
+		bridge.chunkDirty = true;
+	}
+
+	const BinaryType btype = main.info.btype;
+	const PluginType ptype = main.info.ptype;
+	const int64_t uniqueId = main.info.uniqueId;
+	const CarlaString label(main.info.label);
+	const CarlaString filename(main.info.filename);
+	const bool useChunks = main.info.options & PLUGIN_OPTION_USE_CHUNKS;
+	const std::vector<float> values(main.params.values);
+	const bool pipelined = main.is_pipelined();
+	const uint32_t bufferSize = priv->bufferSize;
+	const double sampleRate = priv->sampleRate;
+
+	priv->channelOwner = &main;
+	priv->channelCount = count;
+	priv->channelDone = false;
+	priv->channelOk = false;
+	priv->channelThread = std::thread([=]() {
+		bool ok = true;
+
+		for (uint32_t i = 0; i < count && ok; ++i) {
+			carla_bridge &bridge(*priv->channelBridges[i]);
+
+			bridge.init(bufferSize, sampleRate);
+			bridge.set_pipelined(pipelined);
+
+			run_with_start_limit([&]() {
+				ok = bridge.start(btype, ptype, label, filename,
+						  uniqueId);
+				if (!ok)
+					return;
+
+				bridge.restore_state();
+
+				if (useChunks)
+					return;
+
+				const carla_param_cache &params(bridge.params);
+
+				for (uint32_t j = 0;
+				     j < params.count && j < values.size();
+				     ++j) {
+					if (params.is_input(j))
+						bridge.set_value(j, values[j]);
+				}
+			});
+		}
+
+		priv->channelOk = ok;
+		priv->channelDone = true;
+	});
+}
+
+// number of instances running along `bridge`, none for any other plugin
+static uint32_t carla_priv_channels_for(struct carla_priv *priv,
+					const carla_bridge *bridge)
+{
+	return priv->channelOwner == bridge ? priv->numChannelBridges.load()
+					    : 0;
+}
+
+// mirror [de]activation of the main instance
+static void carla_priv_set_channels_active(struct carla_priv *priv,
+					   bool active)
+{
+	const uint32_t count = carla_priv_channels_for(priv, priv->bridge);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		carla_bridge &bridge(*priv->channelBridges[i]);
+
+		if (bridge.is_active() == active)
+			continue;
+
+		if (active)
+			bridge.activate();
+		else
+			bridge.deactivate();
+	}
+}
+
+// linked parameters, values always come from the main instance
+static void carla_priv_set_channels_value(struct carla_priv *priv,
+					  uint32_t index, float value)
+{
+	const uint32_t count = carla_priv_channels_for(priv, priv->bridge);
+
+	for (uint32_t i = 0; i < count; ++i)
+		priv->channelBridges[i]->set_value(index, value);
+}
+
+static void carla_priv_idle_channels(struct carla_priv *priv)
+{
+	if (priv->channelThread.joinable()) {
+		if (!priv->channelDone)
+			return;
+
+		priv->channelThread.join();
+
+		if (!priv->channelOk) {
+			blog(LOG_WARNING,
+			     "[" CARLA_MODULE_ID
+			     "] failed to start per-channel instances");
+			priv->channelsFailed = true;
+			carla_priv_release_channels(priv);
+		} else if (!priv->channelsRelease) {
+			// audio thread picks them up from the next block on
+			priv->numChannelBridges = priv->channelCount;
+			carla_priv_set_channels_active(
+				priv, priv->bridge->is_active());
+
+			blog(LOG_INFO,
+			     "[" CARLA_MODULE_ID "] running %u instances",
+			     priv->channelCount + 1);
+			return;
+		}
+	}
+
+	// instances of the previous plugin, kept until the crossfade is done
+	if (priv->numChannelBridges != 0 && priv->channelOwner != priv->bridge &&
+	    priv->fadeInBridge == nullptr)
+		carla_priv_release_channels(priv);
+
+	if (priv->channelsRelease) {
+		if (priv->teardownThread.joinable())
+			return;
+
+		std::vector<carla_bridge *> bridges;
+		for (const std::unique_ptr<carla_bridge> &bridge :
+		     priv->channelBridges)
+			bridges.push_back(bridge.get());
+
+		carla_priv_teardown(
+			priv,
+			[bridges]() {
+				for (carla_bridge *bridge : bridges)
+					bridge->cleanup(true, true);
+			},
+			[]() {});
+
+		priv->channelsRelease = false;
+		return;
+	}
+
+	const uint32_t count = priv->numChannelBridges;
+
+	if (!carla_priv_wants_channels(priv)) {
+		if (count != 0)
+			carla_priv_release_channels(priv);
+		return;
+	}
+
+	if (count == 0) {
+		// a plugin switch in progress uses the spare slot audio path,
+		// instances might still be stopping
+		if (priv->channelsFailed || priv->retiredBridge != nullptr ||
+		    priv->teardownThread.joinable())
+			return;
+
+		// instances start from the current state, reported during idle
+		carla_bridge *const main = priv->bridge;
+
+		if (priv->channelSaveBridge != main) {
+			priv->channelSaveBridge = main;
+			main->request_save();
+			return;
+		}
+
+		if (main->is_saving())
+			return;
+
+		priv->channelSaveBridge = nullptr;
+		carla_priv_start_channels(priv);
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if (priv->channelBridges[i]->idle())
+			continue;
+
+		// not restarted until the plugin is loaded again
+		blog(LOG_WARNING,
+		     "[" CARLA_MODULE_ID "] per-channel instance crashed");
+		priv->channelsFailed = true;
+		carla_priv_release_channels(priv);
+		return;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// state snapshots
+// named plugin states stored in the source settings under `PROP_SNAPSHOTS`,
+// each one in the same format as `carla_priv_save` uses
+// the selected snapshot is kept running on the spare slot, so recalling it
+// only needs a crossfade, other snapshots are started first
+
+// returns the index of the named snapshot, or the array size if not found
+static size_t find_snapshot(obs_data_array_t *array, const char *name)
+{
+	const size_t count = obs_data_array_count(array);
+
+	for (size_t i = 0; i < count; ++i) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		const bool found =
+			std::strcmp(obs_data_get_string(item, "name"), name) ==
+			0;
+		obs_data_release(item);
+
+		if (found)
+			return i;
+	}
+
+	return count;
+}
+
+// returns a new reference, or null if not found
+static obs_data_t *get_snapshot_state(obs_data_t *settings, const char *name)
+{
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_SNAPSHOTS);
+	if (array == nullptr)
+		return nullptr;
+
+	obs_data_t *state = nullptr;
+	const size_t index = find_snapshot(array, name);
+
+	if (index < obs_data_array_count(array)) {
+		obs_data_t *item = obs_data_array_item(array, index);
+		state = obs_data_get_obj(item, "state");
+		obs_data_release(item);
+	}
+
+	obs_data_array_release(array);
+	return state;
+}
+
+// refresh the names checked by `carla_priv_recall_snapshot`
+static void carla_priv_cache_snapshot_names(struct carla_priv *priv,
+					    obs_data_t *settings)
+{
+	std::vector<CarlaString> names;
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_SNAPSHOTS);
+
+	if (array != nullptr) {
+		for (size_t i = 0, count = obs_data_array_count(array);
+		     i < count; ++i) {
+			obs_data_t *item = obs_data_array_item(array, i);
+			names.emplace_back(obs_data_get_string(item, "name"));
+			obs_data_release(item);
+		}
+
+		obs_data_array_release(array);
+	}
+
+	const std::lock_guard<std::mutex> lock(priv->snapshotMutex);
+	priv->snapshotNames.swap(names);
+}
+
+// stop the snapshot kept on the spare slot, if any
+// waits for it, used from the UI side
+static void carla_priv_drop_standby(struct carla_priv *priv)
+{
+	join_bridge_thread(priv->standbyThread, priv->standbyDone);
+
+	if (priv->standbyBridge != nullptr) {
+		priv->standbyBridge->cleanup(true, true);
+		priv->standbyBridge = nullptr;
+	}
+
+	priv->standbyName.clear();
+}
+
+// same as `carla_priv_drop_standby`, stopping it on the teardown thread
+// the spare slot stays in use until then
+// must not be starting, nor another teardown running
+static void carla_priv_release_standby(struct carla_priv *priv)
+{
+	if (priv->standbyThread.joinable())
+		priv->standbyThread.join();
+
+	carla_bridge *const standby = priv->standbyBridge;
+
+	if (standby != nullptr) {
+		carla_priv_teardown(
+			priv, [standby]() { standby->cleanup(true, true); },
+			[]() {});
+		priv->standbyBridge = nullptr;
+	}
+
+	priv->standbyName.clear();
+}
+
+// start a snapshot on the spare slot in the background
+// a snapshot that fails to start is not tried again until requested anew
+static void carla_priv_start_standby(struct carla_priv *priv, const char *name)
+{
+	priv->standbyName = name;
+
+	obs_data_t *settings = obs_source_get_settings(priv->source);
+	obs_data_t *state = get_snapshot_state(settings, name);
+	obs_data_release(settings);
+
+	if (state == nullptr)
+		return;
+
+	const BinaryType btype =
+		getBinaryTypeFromString(obs_data_get_string(state, "btype"));
+	const PluginType ptype =
+		getPluginTypeFromString(obs_data_get_string(state, "ptype"));
+
+	if (btype == BINARY_NONE || ptype == PLUGIN_NONE) {
+		obs_data_release(state);
+		return;
+	}
+
+	carla_bridge *const standby = carla_priv_get_spare(priv);
+	const carla_bridge_policy policy(priv->bridge->policy);
+	const bool pipelined = priv->bridge->is_pipelined();
+	const uint32_t bufferSize = priv->bufferSize;
+	const double sampleRate = priv->sampleRate;
+
+	// parameter changes are only reported once recalled
+	standby->callback = nullptr;
+
+	priv->standbyBridge = standby;
+	priv->standbyDone = false;
+	priv->standbyOk = false;
+	priv->standbyThread = std::thread([=]() {
+		standby->policy = policy;
+		standby->init(bufferSize, sampleRate);
+		standby->set_pipelined(pipelined);
+		cache_plugin_state(*standby, state, nullptr);
+
+		run_with_start_limit([=]() {
+			const char *label = obs_data_get_string(state, "label");
+			const char *filename =
+				obs_data_get_string(state, "filename");
+
+			if (!standby->start(btype, ptype, label, filename, 0))
+				return;
+
+			standby->restore_state();
+			apply_state_params(*standby, state);
+
+			// mismatch is handled once recalled
+			if (priv->activeRequested)
+				standby->activate();
+
+			priv->standbyOk = true;
+		});
+
+		// not stopped during idle
+		if (!priv->standbyOk)
+			standby->cleanup(true, true);
+
+		obs_data_release(state);
+		priv->standbyDone = true;
+	});
+}
+
+// snapshot kept on the spare slot needs to be started again
+// can be called from any thread, handled during idle
+static void carla_priv_outdate_standby(struct carla_priv *priv)
+{
+	const std::lock_guard<std::mutex> lock(priv->snapshotMutex);
+	priv->standbyOutdated = true;
+}
+
+// crossfade to the snapshot kept on the spare slot
+static void carla_priv_switch_to_standby(struct carla_priv *priv)
+{
+	carla_bridge *const next = priv->standbyBridge;
+	priv->standbyBridge = nullptr;
+	priv->standbyName.clear();
+
+	// OBS might have [de]activated us in the mean time
+	if (priv->activeRequested != next->is_active())
+		priv->activePending = true;
+
+	// instances follow the old state, kept for the crossfade and started
+	// again once switched, see `carla_priv_idle_channels`
+	carla_priv_start_swap(priv, next);
+	carla_priv_params_to_settings(priv);
+	postpone_update_request(&priv->update_request);
+
+	blog(LOG_INFO, "[" CARLA_MODULE_ID "] recalled snapshot \"%s\"",
+	     priv->recallName.buffer());
+}
+
+static void carla_priv_idle_snapshots(struct carla_priv *priv)
+{
+	const bool standbyBusy = priv->standbyThread.joinable() &&
+				 !priv->standbyDone;
+	CarlaString preload;
+	bool outdated = false;
+
+	{
+		const std::lock_guard<std::mutex> lock(priv->snapshotMutex);
+
+		preload = priv->preloadRequest;
+
+		// wait for a running start or teardown to finish first
+		if (priv->standbyOutdated && !standbyBusy &&
+		    !priv->teardownThread.joinable()) {
+			priv->standbyOutdated = false;
+			outdated = true;
+		}
+
+		if (priv->recallRequest.isNotEmpty()) {
+			priv->recallName = priv->recallRequest;
+			priv->recallRequest.clear();
+		}
+	}
+
+	if (outdated)
+		carla_priv_release_standby(priv);
+
+	if (priv->standbyThread.joinable() && !standbyBusy) {
+		priv->standbyThread.join();
+
+		// already stopped by the thread
+		if (!priv->standbyOk) {
+			blog(LOG_WARNING,
+			     "[" CARLA_MODULE_ID
+			     "] failed to start snapshot \"%s\"",
+			     priv->standbyName.buffer());
+
+			priv->standbyBridge = nullptr;
+		}
+	}
+
+	// a recall takes precedence over the selected snapshot
+	const CarlaString &wanted(priv->recallName.isNotEmpty()
+					  ? priv->recallName
+					  : preload);
+
+	if (priv->standbyName != wanted) {
+		// spare slot must be free, plugin must be started
+		if (standbyBusy || priv->retiredBridge != nullptr ||
+		    priv->teardownThread.joinable() || priv->deferred.pending)
+			return;
+
+		carla_priv_release_standby(priv);
+
+		// otherwise started once the previous one is stopped
+		if (wanted.isNotEmpty() && !priv->teardownThread.joinable())
+			carla_priv_start_standby(priv, wanted);
+
+		return;
+	}
+
+	if (standbyBusy)
+		return;
+
+	if (priv->recallName.isNotEmpty()) {
+		if (priv->standbyBridge != nullptr)
+			carla_priv_switch_to_standby(priv);
+
+		priv->recallName.clear();
+		return;
+	}
+
+	if (priv->standbyBridge != nullptr)
+		priv->standbyBridge->idle();
+}
+
+// same as `carla_priv_wait_start`, also cancelling any scheduled recovery,
+// deferred start, snapshot or plugin switch in progress
+// used when the plugin is replaced or reloaded by the user
+static void carla_priv_stop_recovery(struct carla_priv *priv)
+{
+	carla_priv_wait_start(priv);
+	carla_priv_drop_standby(priv);
+	carla_priv_drop_channels(priv);
+	carla_priv_finish_swap(priv, true);
+
+	priv->channelsFailed = false;
+	priv->recoveryTime = 0;
+	priv->crashCount = 0;
+	priv->deferred.pending = false;
+}
+
+// start the plugin recorded during load, if not started yet
+// audio passes through until the plugin is ready
+static void carla_priv_start_deferred(struct carla_priv *priv)
+{
+	if (!priv->deferred.pending)
+		return;
+
+	priv->deferred.pending = false;
+
+	carla_priv_start_in_background(priv, [priv]() {
+		priv->bridge->init(priv->bufferSize, priv->sampleRate);
+
+		if (!priv->bridge->start(priv->deferred.btype,
+					 priv->deferred.ptype,
+					 priv->deferred.label,
+					 priv->deferred.filename, 0)) {
+			// TODO show error message if bridge fails
+			return;
+		}
+
+		priv->bridge->restore_state();
+		priv->settingsSyncPending = true;
+	});
+}
+
 void carla_priv_destroy(struct carla_priv *priv)
 {
-	priv->bridge.cleanup();
+	{
+		const std::lock_guard<std::recursive_mutex> lock(
+			priv->bridgeMutex);
+
+		carla_priv_stop_recovery(priv);
+		priv->slots[0].cleanup();
+		priv->slots[1].cleanup();
+
+		for (const std::unique_ptr<carla_bridge> &bridge :
+		     priv->channelBridges)
+			bridge->cleanup();
+	}
+
 	delete priv;
 }
 
-// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+// crash recovery
+
+static void carla_priv_recover(struct carla_priv *priv)
+{
+	carla_bridge &bridge(*priv->bridge);
+
+	// cache relevant information for later
+	const BinaryType btype = bridge.info.btype;
+	const PluginType ptype = bridge.info.ptype;
+	const int64_t uniqueId = bridge.info.uniqueId;
+	const CarlaString label(bridge.info.label);
+	const CarlaString filename(bridge.info.filename);
+
+	bridge.cleanup(false, true);
+	bridge.init(priv->bufferSize, priv->sampleRate);
+
+	if (bridge.start(btype, ptype, label, filename, uniqueId)) {
+		bridge.restore_state();
+
+		if (priv->activeRequested)
+			bridge.activate();
+
+		priv->fadePending = true;
+
+		blog(LOG_INFO, "[" CARLA_MODULE_ID "] bridge restarted");
+	} else {
+		blog(LOG_WARNING,
+		     "[" CARLA_MODULE_ID "] failed to restart bridge");
+	}
+}
+
+static void carla_priv_schedule_recovery(struct carla_priv *priv)
+{
+	const uint64_t now = os_gettime_ns();
+
+	if (now - priv->lastCrashTime >= CARLA_RECOVERY_STABLE_NS)
+		priv->crashCount = 0;
+
+	priv->lastCrashTime = now;
+
+	if (++priv->crashCount > CARLA_RECOVERY_MAX_ATTEMPTS) {
+		blog(LOG_ERROR,
+		     "[" CARLA_MODULE_ID "] bridge keeps crashing,"
+		     " not restarting again until manually reloaded");
+
+		// clear crashed status, plugin info is kept for reloading
+		priv->bridge->cleanup(false);
+		return;
+	}
+
+	uint64_t delay = 0;
+
+	if (priv->crashCount > 1) {
+		delay = CARLA_RECOVERY_MIN_DELAY_NS << (priv->crashCount - 2);
+		if (delay > CARLA_RECOVERY_MAX_DELAY_NS)
+			delay = CARLA_RECOVERY_MAX_DELAY_NS;
+	}
+
+	blog(LOG_WARNING,
+	     "[" CARLA_MODULE_ID "] bridge crashed, restarting in %u ms",
+	     static_cast<uint>(delay / 1000000));
+
+	// never 0, which means no recovery scheduled
+	priv->recoveryTime = now + delay + 1;
+}
+
+// returns true while the bridge must not be touched by idle
+static bool carla_priv_idle_recovery(struct carla_priv *priv)
+{
+	if (priv->starting) {
+		if (!priv->startDone)
+			return true;
+
+		carla_priv_wait_start(priv);
+
+		// plugin state loaded in the background, update settings now
+		if (priv->settingsSyncPending) {
+			priv->settingsSyncPending = false;
+			carla_priv_params_to_settings(priv);
+		}
+
+		postpone_update_request(&priv->update_request);
+		return false;
+	}
+
+	if (priv->recoveryTime == 0 || os_gettime_ns() < priv->recoveryTime)
+		return false;
+
+	priv->recoveryTime = 0;
+	carla_priv_start_in_background(priv,
+				       [priv]() { carla_priv_recover(priv); });
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+// apply `activeRequested`, must be called with `bridgeMutex` held
+static void carla_priv_apply_active(struct carla_priv *priv)
+{
+	const bool active = priv->activeRequested;
+
+	if (active)
+		carla_priv_start_deferred(priv);
+
+	// applied once the bridge has started, see `carla_priv_wait_start`
+	if (priv->starting && !priv->startDone)
+		return;
+
+	carla_priv_wait_start(priv);
+
+	if (priv->bridge->is_active() != active) {
+		if (active)
+			priv->bridge->activate();
+		else
+			priv->bridge->deactivate();
+	}
+
+	carla_priv_set_channels_active(priv, active);
+}
+
+// these can be called from the OBS tick thread, which must never wait for
+// the UI side, anything that cannot be done right away is left to idle
+
+void carla_priv_activate(struct carla_priv *priv)
+{
+	priv->activeRequested = true;
+
+	std::unique_lock<std::recursive_mutex> lock(priv->bridgeMutex,
+						    std::try_to_lock);
+	if (!lock.owns_lock()) {
+		priv->activePending = true;
+		return;
+	}
+
+	carla_priv_apply_active(priv);
+}
+
+void carla_priv_deactivate(struct carla_priv *priv)
+{
+	priv->activeRequested = false;
+
+	std::unique_lock<std::recursive_mutex> lock(priv->bridgeMutex,
+						    std::try_to_lock);
+	if (!lock.owns_lock()) {
+		priv->activePending = true;
+		return;
+	}
+
+	carla_priv_apply_active(priv);
+}
+
+void carla_priv_show(struct carla_priv *priv)
+{
+	std::unique_lock<std::recursive_mutex> lock(priv->bridgeMutex,
+						    std::try_to_lock);
+	if (!lock.owns_lock()) {
+		priv->startPending = true;
+		return;
+	}
+
+	carla_priv_start_deferred(priv);
+}
+
+// process `bridge` and the per-channel instances, if any, all at once
+// a plugin and its per-channel instances working on one block
+struct carla_process_planes {
+	carla_bridge *bridge;
+	uint32_t count;
+	float *planes[MAX_AV_PLANES][MAX_AV_PLANES];
+};
+
+// start processing `bridge` and its instances, all of them work at once
+// until `carla_priv_process_end`
+static void carla_priv_process_begin(struct carla_priv *priv,
+				     carla_process_planes &p,
+				     carla_bridge *bridge,
+				     float *buffers[MAX_AV_PLANES],
+				     uint32_t frames)
+{
+	p.bridge = bridge;
+	p.count = carla_priv_channels_for(priv, bridge);
+
+	if (p.count == 0) {
+		for (uint32_t c = 0; c < MAX_AV_PLANES; ++c)
+			p.planes[0][c] = buffers[c];
+	} else {
+		// each instance only sees its own plane, the rest goes to
+		// scratch
+		for (uint32_t i = 0; i <= p.count; ++i) {
+			p.planes[i][0] = buffers[i];
+
+			for (uint32_t c = 1; c < MAX_AV_PLANES; ++c)
+				p.planes[i][c] = priv->scratchBuffer;
+		}
+	}
+
+	bridge->process_begin(p.planes[0], frames);
+
+	for (uint32_t i = 0; i < p.count; ++i)
+		priv->channelBridges[i]->process_begin(p.planes[i + 1],
+						       frames);
+}
+
+static void carla_priv_process_end(struct carla_priv *priv,
+				   carla_process_planes &p, uint32_t frames)
+{
+	p.bridge->process_end(p.planes[0], frames);
+
+	for (uint32_t i = 0; i < p.count; ++i)
+		priv->channelBridges[i]->process_end(p.planes[i + 1], frames);
+}
+
+static void carla_priv_process_bridge(struct carla_priv *priv,
+				      carla_bridge *bridge,
+				      float *buffers[MAX_AV_PLANES],
+				      uint32_t frames)
+{
+	carla_process_planes p;
+	carla_priv_process_begin(priv, p, bridge, buffers, frames);
+	carla_priv_process_end(priv, p, frames);
+}
+
+// fade from dry to processed audio, avoiding a click after a restart
+static void carla_priv_process_fade(struct carla_priv *priv,
+				    carla_bridge *bridge,
+				    float *buffers[MAX_AV_PLANES],
+				    uint32_t frames)
+{
+	if (priv->fadePending.exchange(false)) {
+		priv->fadePos = 0;
+		priv->fadeLength = static_cast<uint32_t>(
+			priv->sampleRate * CARLA_RECOVERY_FADE_MS / 1000);
+	}
+
+	if (priv->fadePos >= priv->fadeLength) {
+		carla_priv_process_bridge(priv, bridge, buffers, frames);
+		return;
+	}
+
+	for (uint32_t c = 0; c < MAX_AV_PLANES; ++c)
+		carla_copyFloats(priv->dryBuffers[c], buffers[c], frames);
+
+	carla_priv_process_bridge(priv, bridge, buffers, frames);
+
+	const uint32_t fadePos = priv->fadePos;
+
+	for (uint32_t c = 0; c < MAX_AV_PLANES; ++c) {
+		for (uint32_t i = 0; i < frames; ++i) {
+			const uint32_t pos = fadePos + i;
+			if (pos >= priv->fadeLength)
+				break;
+
+			const float gain = static_cast<float>(pos) /
+					   static_cast<float>(priv->fadeLength);
+			buffers[c][i] = priv->dryBuffers[c][i] * (1.f - gain) +
+					buffers[c][i] * gain;
+		}
+	}
+
+	priv->fadePos = std::min(fadePos + frames, priv->fadeLength);
+}
+
+// equal-power crossfade from the current to the new plugin, both running
+// on the same input, see `carla_priv_replace_plugin`
+static void carla_priv_process_swap(struct carla_priv *priv,
+				    carla_bridge *bridge,
+				    carla_bridge *fadeInBridge,
+				    float *buffers[MAX_AV_PLANES],
+				    uint32_t frames)
+{
+	if (priv->swapPending.exchange(false)) {
+		priv->swapPos = 0;
+		priv->swapLength = std::max(
+			1u, static_cast<uint32_t>(priv->sampleRate *
+						  CARLA_SWAP_FADE_MS / 1000));
+	}
+
+	float *swapBuffers[MAX_AV_PLANES];
+
+	for (uint32_t c = 0; c < MAX_AV_PLANES; ++c) {
+		swapBuffers[c] = priv->swapBuffers[c];
+		carla_copyFloats(swapBuffers[c], buffers[c], frames);
+	}
+
+	// both plugins work on the block at once
+	carla_process_planes out;
+	carla_process_planes in;
+
+	carla_priv_process_begin(priv, out, bridge, buffers, frames);
+	carla_priv_process_begin(priv, in, fadeInBridge, swapBuffers, frames);
+	carla_priv_process_end(priv, out, frames);
+	carla_priv_process_end(priv, in, frames);
+
+	const uint32_t swapPos = priv->swapPos;
 
-void carla_priv_activate(struct carla_priv *priv)
-{
-	priv->bridge.activate();
-}
+	for (uint32_t i = 0; i < frames; ++i) {
+		const uint32_t pos = swapPos + i;
+		float gainOut = 0.f;
+		float gainIn = 1.f;
 
-void carla_priv_deactivate(struct carla_priv *priv)
-{
-	priv->bridge.deactivate();
+		if (pos < priv->swapLength) {
+			// 0 to pi/2
+			const float x = 1.5707963f * static_cast<float>(pos) /
+					static_cast<float>(priv->swapLength);
+			gainOut = std::cos(x);
+			gainIn = std::sin(x);
+		}
+
+		for (uint32_t c = 0; c < MAX_AV_PLANES; ++c)
+			buffers[c][i] = buffers[c][i] * gainOut +
+					swapBuffers[c][i] * gainIn;
+	}
+
+	priv->swapPos = std::min(swapPos + frames, priv->swapLength);
+
+	// new plugin takes over from the next block on
+	if (priv->swapPos >= priv->swapLength) {
+		priv->audioBridge = fadeInBridge;
+		priv->fadeInBridge = nullptr;
+	}
 }
 
 void carla_priv_process_audio(struct carla_priv *priv,
 			      float *buffers[MAX_AV_PLANES], uint32_t frames)
 {
-	priv->bridge.process(buffers, frames);
+	// keep dry audio while restarting
+	if (priv->starting)
+		return;
+
+	priv->audioBusy = true;
+
+	carla_bridge *const bridge = priv->audioBridge;
+	carla_bridge *const fadeInBridge = priv->fadeInBridge;
+
+	if (fadeInBridge != nullptr)
+		carla_priv_process_swap(priv, bridge, fadeInBridge, buffers,
+					frames);
+	else
+		carla_priv_process_fade(priv, bridge, buffers, frames);
+
+	priv->audioBusy = false;
 }
 
 void carla_priv_idle(struct carla_priv *priv)
 {
-	if (!priv->bridge.idle()) {
-		// bridge crashed!
-		// TODO something
+	// UI side is busy with the bridge, try again on the next tick
+	std::unique_lock<std::recursive_mutex> lock(priv->bridgeMutex,
+						    std::try_to_lock);
+	if (!lock.owns_lock())
+		return;
+
+	if (priv->activePending.exchange(false))
+		carla_priv_apply_active(priv);
+
+	if (priv->startPending.exchange(false))
+		carla_priv_start_deferred(priv);
+
+	carla_priv_collect_teardown(priv, false);
+	carla_priv_finish_swap(priv, false);
+
+	if (carla_priv_idle_recovery(priv))
+		return;
+
+	carla_priv_idle_snapshots(priv);
+	carla_priv_idle_channels(priv);
+
+	if (!priv->bridge->idle()) {
+		// bridge crashed, restart it in the background
+		if (priv->bridge->has_crashed() && priv->recoveryTime == 0)
+			carla_priv_schedule_recovery(priv);
+	}
+
+	if (!priv->changedParams.empty()) {
+		const carla_param_cache &params(priv->bridge->params);
+		obs_data_t *settings = obs_source_get_settings(priv->source);
+
+		for (uint32_t index : priv->changedParams) {
+			priv->changedParamFlags[index] = false;
+
+			// parameters might have been reloaded meanwhile
+			if (index >= params.count || !params.is_input(index))
+				continue;
+
+			param_value_to_settings(params, settings, index);
+			carla_priv_set_channels_value(priv, index,
+						      params.values[index]);
+		}
+
+		obs_data_release(settings);
+
+		priv->changedParams.clear();
+		postpone_update_request(&priv->update_request);
 	}
 
 	handle_update_request(priv->source, &priv->update_request);
@@ -122,23 +1701,54 @@ void carla_priv_idle(struct carla_priv *priv)
 
 void carla_priv_save(struct carla_priv *priv, obs_data_t *settings)
 {
-	priv->bridge.save_and_wait();
-
-	obs_data_set_string(settings, "btype",
-			    getBinaryTypeAsString(priv->bridge.info.btype));
-	obs_data_set_string(settings, "ptype",
-			    getPluginTypeAsString(priv->bridge.info.ptype));
-	obs_data_set_string(settings, "filename", priv->bridge.info.filename);
-	obs_data_set_string(settings, "label", priv->bridge.info.label);
-
-	if (!priv->bridge.customData.empty()) {
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_wait_start(priv);
+
+	// not started yet, save back what was loaded
+	const bool pending = priv->deferred.pending;
+
+	if (!pending)
+		priv->bridge->save_and_wait();
+
+	const BinaryType btype = pending ? priv->deferred.btype
+					 : priv->bridge->info.btype;
+	const PluginType ptype = pending ? priv->deferred.ptype
+					 : priv->bridge->info.ptype;
+
+	obs_data_set_int(settings, "state-version", CARLA_STATE_VERSION);
+	obs_data_set_string(settings, "btype", getBinaryTypeAsString(btype));
+	obs_data_set_string(settings, "ptype", getPluginTypeAsString(ptype));
+	obs_data_set_string(settings, "filename",
+			    pending ? priv->deferred.filename
+				    : priv->bridge->info.filename);
+	obs_data_set_string(settings, "label",
+			    pending ? priv->deferred.label
+				    : priv->bridge->info.label);
+
+	if (!priv->bridge->customData.empty()) {
 		obs_data_array_t *array = obs_data_array_create();
 
-		for (CustomData &cdata : priv->bridge.customData) {
+		for (uint32_t i = 0, count = priv->bridge->customData.count();
+		     i < count; ++i) {
+			const carla_custom_data_store::item cdata(
+				priv->bridge->customData.get(i));
+
 			obs_data_t *data = obs_data_create();
 			obs_data_set_string(data, "type", cdata.type);
 			obs_data_set_string(data, "key", cdata.key);
-			obs_data_set_string(data, "value", cdata.value);
+
+			if (cdata.valueLen > CARLA_STATE_COMPRESS_THRESHOLD) {
+				obs_data_set_bool(data, "compressed", true);
+				obs_data_set_string(
+					data, "value",
+					encode_state_data(cdata.value,
+							  cdata.valueLen)
+						.constData());
+			} else {
+				obs_data_set_string(data, "value",
+						    cdata.value);
+			}
+
 			obs_data_array_push_back(array, data);
 			obs_data_release(data);
 		}
@@ -149,22 +1759,26 @@ void carla_priv_save(struct carla_priv *priv, obs_data_t *settings)
 		obs_data_erase(settings, PROP_CUSTOM_DATA);
 	}
 
+	const carla_param_cache &params(priv->bridge->params);
 	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
 
-	if ((priv->bridge.info.options & PLUGIN_OPTION_USE_CHUNKS) &&
-	    !priv->bridge.chunk.isEmpty()) {
-		char *b64ptr = CarlaString::asBase64(priv->bridge.chunk.data(),
-						     priv->bridge.chunk.size())
-				       .releaseBufferPointer();
-		const CarlaString b64chunk(b64ptr, false);
-		obs_data_set_string(settings, PROP_CHUNK, b64chunk.buffer());
+	// plugin options are unknown while pending, keep any loaded chunk
+	if ((pending ||
+	     (priv->bridge->info.options & PLUGIN_OPTION_USE_CHUNKS)) &&
+	    !priv->bridge->chunk.isEmpty()) {
+		// only encode the chunk again if it changed since last time
+		if (priv->bridge->chunkDirty || priv->encodedChunk.isEmpty()) {
+			priv->encodedChunk = encode_state_data(
+				priv->bridge->chunk.constData(),
+				priv->bridge->chunk.size());
+			priv->bridge->chunkDirty = false;
+		}
 
-		for (uint32_t i = 0;
-		     i < priv->bridge.paramCount && i < MAX_PARAMS; ++i) {
-			const carla_param_data &param(
-				priv->bridge.paramDetails[i]);
+		obs_data_set_string(settings, PROP_CHUNK,
+				    priv->encodedChunk.constData());
 
-			if ((param.hints & PARAMETER_IS_ENABLED) == 0)
+		for (uint32_t i = 0; i < params.count; ++i) {
+			if (!params.is_input(i))
 				continue;
 
 			param_index_to_name(i, pname);
@@ -173,96 +1787,145 @@ void carla_priv_save(struct carla_priv *priv, obs_data_t *settings)
 	} else {
 		obs_data_erase(settings, PROP_CHUNK);
 
-		for (uint32_t i = 0;
-		     i < priv->bridge.paramCount && i < MAX_PARAMS; ++i) {
-			const carla_param_data &param(
-				priv->bridge.paramDetails[i]);
-
-			if ((param.hints & PARAMETER_IS_ENABLED) == 0)
+		for (uint32_t i = 0; i < params.count; ++i) {
+			if (!params.is_input(i))
 				continue;
 
-			param_index_to_name(i, pname);
-
-			if (param.hints & PARAMETER_IS_BOOLEAN) {
-				obs_data_set_bool(settings, pname,
-						  carla_isEqual(param.value,
-								param.max));
-			} else if (param.hints & PARAMETER_IS_INTEGER) {
-				obs_data_set_int(settings, pname, param.value);
-			} else {
-				obs_data_set_double(settings, pname,
-						    param.value);
-			}
+			param_value_to_settings(params, settings, i);
 		}
 	}
 }
 
 void carla_priv_load(struct carla_priv *priv, obs_data_t *settings)
 {
-	const char *btype = obs_data_get_string(settings, "btype");
-	const char *ptype = obs_data_get_string(settings, "ptype");
-	const char *filename = obs_data_get_string(settings, "filename");
-	const char *label = obs_data_get_string(settings, "label");
-	int64_t uniqueId = 0;
+	const BinaryType btype =
+		getBinaryTypeFromString(obs_data_get_string(settings, "btype"));
+	const PluginType ptype =
+		getPluginTypeFromString(obs_data_get_string(settings, "ptype"));
+	const CarlaString filename(obs_data_get_string(settings, "filename"));
+	const CarlaString label(obs_data_get_string(settings, "label"));
 
-	priv->bridge.cleanup();
-	priv->bridge.init(priv->bufferSize, priv->sampleRate);
+	carla_priv_cache_snapshot_names(priv, settings);
 
-	if (!priv->bridge.start(getBinaryTypeFromString(btype),
-				getPluginTypeFromString(ptype), label, filename,
-				uniqueId)) {
-		// TODO show error message if bridge fails
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_stop_recovery(priv);
+	priv->bridge->cleanup(true, true);
+
+	if (btype == BINARY_NONE || ptype == PLUGIN_NONE)
 		return;
-	}
 
-	obs_data_array_t *array =
-		obs_data_get_array(settings, PROP_CUSTOM_DATA);
-	if (array) {
-		const size_t count = obs_data_array_count(array);
-		for (size_t i = 0; i < count; ++i) {
-			obs_data_t *data = obs_data_array_item(array, i);
-			const char *type = obs_data_get_string(data, "type");
-			const char *key = obs_data_get_string(data, "key");
-			const char *value = obs_data_get_string(data, "value");
-			priv->bridge.add_custom_data(type, key, value);
-		}
-		priv->bridge.custom_data_loaded();
-	}
+	// cache state now, it is sent once the bridge is running
+	cache_plugin_state(*priv->bridge, settings, &priv->encodedChunk);
 
-	if (priv->bridge.info.options & PLUGIN_OPTION_USE_CHUNKS) {
-		const char *b64chunk =
-			obs_data_get_string(settings, PROP_CHUNK);
-		priv->bridge.load_chunk(b64chunk);
-	} else {
-		for (uint32_t i = 0; i < priv->bridge.paramCount; ++i) {
-			const carla_param_data &param(
-				priv->bridge.paramDetails[i]);
+	priv->deferred.pending = true;
+	priv->deferred.btype = btype;
+	priv->deferred.ptype = ptype;
+	priv->deferred.label = label;
+	priv->deferred.filename = filename;
 
-			priv->bridge.set_value(i, param.value);
-		}
-	}
+	// start the bridge without blocking, OBS loads sources one by one
+	// or wait until the source is actually used
+	if (!obs_data_get_bool(settings, PROP_LAZY_START))
+		carla_priv_start_deferred(priv);
+}
 
-	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+// ----------------------------------------------------------------------------
 
-	for (uint32_t i = 0; i < priv->bridge.paramCount && i < MAX_PARAMS;
-	     ++i) {
-		const carla_param_data &param(priv->bridge.paramDetails[i]);
+void carla_priv_set_per_channel(struct carla_priv *priv, uint32_t channels)
+{
+	channels = std::min<uint32_t>(channels, MAX_AV_PLANES);
 
-		if ((param.hints & PARAMETER_IS_ENABLED) == 0)
-			continue;
+	if (priv->perChannel == channels)
+		return;
 
-		param_index_to_name(i, pname);
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
 
-		if (param.hints & PARAMETER_IS_BOOLEAN) {
-			obs_data_set_bool(settings, pname,
-					  carla_isEqual(param.value,
-							param.max));
-		} else if (param.hints & PARAMETER_IS_INTEGER) {
-			obs_data_set_int(settings, pname, param.value);
-		} else {
-			obs_data_set_double(settings, pname, param.value);
-		}
+	// instances are started again during idle, if needed
+	carla_priv_drop_channels(priv);
+
+	priv->perChannel = channels;
+	priv->channelsFailed = false;
+}
+
+void carla_priv_save_snapshot(struct carla_priv *priv, const char *name)
+{
+	if (name == nullptr || name[0] == '\0')
+		return;
+
+	obs_data_t *state = obs_data_create();
+	carla_priv_save(priv, state);
+
+	obs_data_t *settings = obs_source_get_settings(priv->source);
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_SNAPSHOTS);
+	if (array == nullptr)
+		array = obs_data_array_create();
+
+	// replace existing snapshot with the same name
+	const size_t index = find_snapshot(array, name);
+	if (index < obs_data_array_count(array))
+		obs_data_array_erase(array, index);
+
+	obs_data_t *item = obs_data_create();
+	obs_data_set_string(item, "name", name);
+	obs_data_set_obj(item, "state", state);
+	obs_data_array_push_back(array, item);
+	obs_data_release(item);
+
+	obs_data_set_array(settings, PROP_SNAPSHOTS, array);
+	obs_data_array_release(array);
+	carla_priv_cache_snapshot_names(priv, settings);
+	obs_data_release(settings);
+	obs_data_release(state);
+
+	const std::lock_guard<std::mutex> lock(priv->snapshotMutex);
+	if (priv->preloadRequest == name)
+		priv->standbyOutdated = true;
+}
+
+void carla_priv_delete_snapshot(struct carla_priv *priv, const char *name)
+{
+	if (name == nullptr || name[0] == '\0')
+		return;
+
+	obs_data_t *settings = obs_source_get_settings(priv->source);
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_SNAPSHOTS);
+
+	if (array != nullptr) {
+		const size_t index = find_snapshot(array, name);
+		if (index < obs_data_array_count(array))
+			obs_data_array_erase(array, index);
+
+		obs_data_array_release(array);
 	}
+
+	carla_priv_cache_snapshot_names(priv, settings);
+	obs_data_release(settings);
+
+	const std::lock_guard<std::mutex> lock(priv->snapshotMutex);
+	if (priv->preloadRequest == name)
+		priv->standbyOutdated = true;
+}
+
+void carla_priv_preload_snapshot(struct carla_priv *priv, const char *name)
+{
+	const std::lock_guard<std::mutex> lock(priv->snapshotMutex);
+	priv->preloadRequest = name != nullptr ? name : "";
+}
+
+bool carla_priv_recall_snapshot(struct carla_priv *priv, const char *name)
+{
+	if (name == nullptr || name[0] == '\0')
+		return false;
+
+	// state is looked up during idle, settings are not touched here
+	const std::lock_guard<std::mutex> lock(priv->snapshotMutex);
+
+	if (std::find(priv->snapshotNames.begin(), priv->snapshotNames.end(),
+		      name) == priv->snapshotNames.end())
+		return false;
+
+	priv->recallRequest = name;
+	return true;
 }
 
 // ----------------------------------------------------------------------------
@@ -270,20 +1933,88 @@ void carla_priv_load(struct carla_priv *priv, obs_data_t *settings)
 void carla_priv_set_buffer_size(struct carla_priv *priv,
 				enum buffer_size_mode bufsize)
 {
-	priv->bridge.set_buffer_size(bufsize_mode_to_frames(bufsize));
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_wait_start(priv);
+	carla_priv_finish_swap(priv, true);
+	carla_priv_outdate_standby(priv);
+	carla_priv_drop_channels(priv);
+
+	priv->bufferSize = bufsize_mode_to_frames(bufsize);
+	priv->bridge->set_buffer_size(priv->bufferSize);
+}
+
+// module-wide process policy, from the environment
+static const carla_bridge_policy &get_default_policy()
+{
+	static const carla_bridge_policy policy = []() {
+		carla_bridge_policy p;
+
+		if (const char *cpus = getenv("CARLA_OBS_BRIDGE_CPUS"))
+			p.cpus = cpus;
+		if (const char *nice = getenv("CARLA_OBS_BRIDGE_NICE"))
+			p.nice = atoi(nice);
+		if (const char *rt = getenv("CARLA_OBS_BRIDGE_REALTIME"))
+			p.realtime = atoi(rt) != 0;
+		if (const char *node = getenv("CARLA_OBS_BRIDGE_NUMA_NODE"))
+			p.numaNode = atoi(node);
+		if (const char *lock = getenv("CARLA_OBS_BRIDGE_MLOCK"))
+			p.lockMemory = atoi(lock) != 0;
+
+		return p;
+	}();
+
+	return policy;
+}
+
+void carla_priv_set_process_policy(struct carla_priv *priv, const char *cpus,
+				   int nice, bool realtime, int numaNode,
+				   bool lockMemory)
+{
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_wait_start(priv);
+
+	const carla_bridge_policy &defaults(get_default_policy());
+	carla_bridge_policy &policy(priv->bridge->policy);
+
+	policy.cpus = cpus != nullptr && cpus[0] != '\0' ? cpus
+							 : defaults.cpus.buffer();
+	policy.nice = nice != 0 ? nice : defaults.nice;
+	policy.realtime = realtime || defaults.realtime;
+	policy.numaNode = numaNode >= 0 ? numaNode : defaults.numaNode;
+	policy.lockMemory = lockMemory || defaults.lockMemory;
+}
+
+void carla_priv_set_pipelined(struct carla_priv *priv, bool pipelined)
+{
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_wait_start(priv);
+	carla_priv_finish_swap(priv, true);
+	carla_priv_outdate_standby(priv);
+	carla_priv_drop_channels(priv);
+
+	// plugin must not be processing while changing modes
+	const bool activated = priv->bridge->is_active();
+
+	if (activated)
+		priv->bridge->deactivate();
+
+	priv->bridge->set_pipelined(pipelined);
+
+	if (activated)
+		priv->bridge->activate();
 }
 
 // ----------------------------------------------------------------------------
 
+static bool carla_priv_sync_properties(struct carla_priv *priv,
+				       obs_properties_t *props);
+
 static bool carla_post_load_callback(struct carla_priv *priv,
 				     obs_properties_t *props)
 {
-	obs_source_t *source = priv->source;
-	obs_data_t *settings = obs_source_get_settings(source);
-	remove_all_props(props, settings);
-	carla_priv_readd_properties(priv, props, true);
-	obs_data_release(settings);
-	return true;
+	// compare against the previous plugin layout and only apply changes,
+	// returns false when there is nothing to refresh
+	return carla_priv_sync_properties(priv, props);
 }
 
 static bool carla_priv_load_file_callback(obs_properties_t *props,
@@ -323,12 +2054,11 @@ static bool carla_priv_load_file_callback(obs_properties_t *props,
 		btype = getBinaryTypeFromFile(filename);
 	}
 
-	priv->bridge.cleanup();
-	priv->bridge.init(priv->bufferSize, priv->sampleRate);
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_stop_recovery(priv);
 
 	// TODO show error message if bridge fails
-	if (priv->bridge.start(btype, ptype, "", filename, 0))
-		priv->bridge.activate();
+	carla_priv_replace_plugin(priv, btype, ptype, "", filename, 0);
 
 	return carla_post_load_callback(priv, props);
 }
@@ -348,15 +2078,14 @@ static bool carla_priv_select_plugin_callback(obs_properties_t *props,
 	if (plugin == NULL)
 		return false;
 
-	priv->bridge.cleanup();
-	priv->bridge.init(priv->bufferSize, priv->sampleRate);
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_stop_recovery(priv);
 
 	// TODO show error message if bridge fails
-	if (priv->bridge.start(static_cast<BinaryType>(plugin->build),
-			       static_cast<PluginType>(plugin->type),
-			       plugin->label, plugin->filename,
-			       plugin->uniqueId))
-		priv->bridge.activate();
+	carla_priv_replace_plugin(priv, static_cast<BinaryType>(plugin->build),
+				  static_cast<PluginType>(plugin->type),
+				  plugin->label, plugin->filename,
+				  plugin->uniqueId);
 
 	return carla_post_load_callback(priv, props);
 }
@@ -368,28 +2097,31 @@ static bool carla_priv_reload_callback(obs_properties_t *props,
 
 	struct carla_priv *priv = static_cast<struct carla_priv *>(data);
 
-	if (priv->bridge.is_running()) {
-		priv->bridge.reload();
-		return true;
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+	carla_priv_stop_recovery(priv);
+
+	if (priv->bridge->is_running()) {
+		priv->bridge->reload();
+		return carla_post_load_callback(priv, props);
 	}
 
-	if (priv->bridge.info.btype == BINARY_NONE)
+	if (priv->bridge->info.btype == BINARY_NONE)
 		return false;
 
 	// cache relevant information for later
-	const BinaryType btype = priv->bridge.info.btype;
-	const PluginType ptype = priv->bridge.info.ptype;
-	const int64_t uniqueId = priv->bridge.info.uniqueId;
-	char *const label = priv->bridge.info.label.releaseBufferPointer();
+	const BinaryType btype = priv->bridge->info.btype;
+	const PluginType ptype = priv->bridge->info.ptype;
+	const int64_t uniqueId = priv->bridge->info.uniqueId;
+	char *const label = priv->bridge->info.label.releaseBufferPointer();
 	char *const filename =
-		priv->bridge.info.filename.releaseBufferPointer();
+		priv->bridge->info.filename.releaseBufferPointer();
 
-	priv->bridge.cleanup(false);
-	priv->bridge.init(priv->bufferSize, priv->sampleRate);
+	priv->bridge->cleanup(false, true);
+	priv->bridge->init(priv->bufferSize, priv->sampleRate);
 
-	if (priv->bridge.start(btype, ptype, label, filename, uniqueId)) {
-		priv->bridge.restore_state();
-		priv->bridge.activate();
+	if (priv->bridge->start(btype, ptype, label, filename, uniqueId)) {
+		priv->bridge->restore_state();
+		priv->bridge->activate();
 	}
 
 	// TODO show error message if bridge fails
@@ -408,7 +2140,10 @@ static bool carla_priv_show_gui_callback(obs_properties_t *props,
 
 	struct carla_priv *priv = static_cast<struct carla_priv *>(data);
 
-	priv->bridge.show_ui();
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+
+	if (!priv->starting)
+		priv->bridge->show_ui();
 
 	return false;
 }
@@ -421,6 +2156,11 @@ static bool carla_priv_param_changed(void *data, obs_properties_t *props,
 
 	struct carla_priv *priv = static_cast<struct carla_priv *>(data);
 
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+
+	if (priv->starting)
+		return false;
+
 	const char *const pname = obs_property_name(property);
 	if (pname == NULL)
 		return false;
@@ -431,13 +2171,13 @@ static bool carla_priv_param_changed(void *data, obs_properties_t *props,
 
 	const int pindex = atoi(pname2);
 
-	if (pindex < 0 || pindex >= (int)priv->bridge.paramCount)
+	if (pindex < 0 || pindex >= (int)priv->bridge->params.count)
 		return false;
 
 	const uint index = static_cast<uint>(pindex);
 
-	const float min = priv->bridge.paramDetails[index].min;
-	const float max = priv->bridge.paramDetails[index].max;
+	const float min = priv->bridge->params.mins[index];
+	const float max = priv->bridge->params.maxs[index];
 
 	float value;
 	switch (obs_property_get_type(property)) {
@@ -462,11 +2202,173 @@ static bool carla_priv_param_changed(void *data, obs_properties_t *props,
 		return false;
 	}
 
-	priv->bridge.set_value(index, value);
+	priv->bridge->set_value(index, value);
+	carla_priv_set_channels_value(priv, index, value);
 
 	return false;
 }
 
+static void carla_priv_add_param_prop(struct carla_priv *priv,
+				      obs_properties_t *props,
+				      obs_data_t *settings, uint32_t index)
+{
+	const carla_param_cache &params(priv->bridge->params);
+	const uint32_t hints = params.hints[index];
+
+	if ((hints & PARAMETER_IS_ENABLED) == 0)
+		return;
+
+	if (params.outputs[index]) {
+		add_output_param_prop(props, index, params.get_name(index),
+				      params.values[index],
+				      params.get_unit(index));
+		return;
+	}
+
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+	param_index_to_name(index, pname);
+
+	obs_property_t *prop;
+
+	if (hints & PARAMETER_IS_BOOLEAN) {
+		prop = obs_properties_add_bool(props, pname,
+					       params.get_name(index));
+
+		obs_data_set_default_bool(settings, pname,
+					  carla_isEqual(params.defs[index],
+							params.maxs[index]));
+	} else if (hints & PARAMETER_IS_INTEGER) {
+		prop = obs_properties_add_int_slider(
+			props, pname, params.get_name(index),
+			params.mins[index], params.maxs[index],
+			params.steps[index]);
+
+		obs_data_set_default_int(settings, pname, params.defs[index]);
+
+		if (params.units[index] != 0)
+			obs_property_int_set_suffix(prop,
+						    params.get_unit(index));
+	} else {
+		prop = obs_properties_add_float_slider(
+			props, pname, params.get_name(index),
+			params.mins[index], params.maxs[index],
+			params.steps[index]);
+
+		obs_data_set_default_double(settings, pname,
+					    params.defs[index]);
+
+		if (params.units[index] != 0)
+			obs_property_float_set_suffix(prop,
+						      params.get_unit(index));
+	}
+
+	obs_property_set_modified_callback2(prop, carla_priv_param_changed,
+					    priv);
+}
+
+// update an existing parameter property in place, keeping its position
+// returns false if the property needs to be created again instead
+static bool carla_priv_update_param_prop(struct carla_priv *priv,
+					 obs_properties_t *props,
+					 obs_data_t *settings, uint32_t index)
+{
+	const carla_param_cache &params(priv->bridge->params);
+
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+	param_index_to_name(index, pname);
+
+	obs_property_t *prop = obs_properties_get(props, pname);
+
+	if (prop == nullptr)
+		return false;
+
+	obs_property_set_description(prop, params.get_name(index));
+
+	switch (get_param_prop_kind(params, index)) {
+	case PARAM_PROP_BOOL:
+		obs_data_set_default_bool(settings, pname,
+					  carla_isEqual(params.defs[index],
+							params.maxs[index]));
+		break;
+	case PARAM_PROP_INT:
+		obs_property_int_set_limits(prop, params.mins[index],
+					    params.maxs[index],
+					    params.steps[index]);
+		obs_property_int_set_suffix(prop, params.get_unit(index));
+		obs_data_set_default_int(settings, pname, params.defs[index]);
+		break;
+	case PARAM_PROP_FLOAT:
+		obs_property_float_set_limits(prop, params.mins[index],
+					      params.maxs[index],
+					      params.steps[index]);
+		obs_property_float_set_suffix(prop, params.get_unit(index));
+		obs_data_set_default_double(settings, pname,
+					    params.defs[index]);
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+static void carla_priv_add_param_props(struct carla_priv *priv,
+				       obs_properties_t *props,
+				       obs_data_t *settings)
+{
+	const uint32_t first = priv->paramPage * PARAMS_PER_PAGE;
+	const uint32_t last =
+		std::min(priv->bridge->params.count, first + PARAMS_PER_PAGE);
+
+	for (uint32_t i = first; i < last; ++i)
+		carla_priv_add_param_prop(priv, props, settings, i);
+}
+
+static bool carla_priv_param_page_changed(void *data, obs_properties_t *props,
+					  obs_property_t *property,
+					  obs_data_t *settings)
+{
+	UNUSED_PARAMETER(property);
+
+	struct carla_priv *priv = static_cast<struct carla_priv *>(data);
+
+	const uint32_t page = obs_data_get_int(settings, PROP_PARAM_PAGE);
+
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+
+	if (priv->starting || page == priv->paramPage ||
+	    page >= get_param_page_count(priv->bridge->params.count))
+		return false;
+
+	// only the parameters of the selected page are created
+	remove_param_props(props);
+	priv->paramPage = page;
+	carla_priv_add_param_props(priv, props, settings);
+
+	return true;
+}
+
+// add all plugin-specific properties, after the fixed buttons
+static void carla_priv_add_plugin_props(struct carla_priv *priv,
+					obs_properties_t *props,
+					obs_data_t *settings)
+{
+	if (priv->bridge->info.hints & PLUGIN_HAS_CUSTOM_UI) {
+		obs_properties_add_button2(props, PROP_SHOW_GUI,
+					   obs_module_text("Show custom GUI"),
+					   carla_priv_show_gui_callback, priv);
+	}
+
+	add_param_page_list(props, priv->bridge->params.count,
+			    carla_priv_param_page_changed, priv);
+
+	carla_priv_add_param_props(priv, props, settings);
+
+	priv->publishedParams = priv->bridge->params;
+	priv->publishedCustomUI =
+		(priv->bridge->info.hints & PLUGIN_HAS_CUSTOM_UI) != 0;
+}
+
 void carla_priv_readd_properties(struct carla_priv *priv,
 				 obs_properties_t *props, bool reset)
 {
@@ -485,70 +2387,182 @@ void carla_priv_readd_properties(struct carla_priv *priv,
 					   carla_priv_reload_callback, priv);
 	}
 
-	if (priv->bridge.info.hints & PLUGIN_HAS_CUSTOM_UI) {
-		obs_properties_add_button2(props, PROP_SHOW_GUI,
-					   obs_module_text("Show custom GUI"),
-					   carla_priv_show_gui_callback, priv);
+	const std::lock_guard<std::recursive_mutex> lock(priv->bridgeMutex);
+
+	// plugin details are not known yet, idle updates us once started
+	carla_priv_start_deferred(priv);
+
+	if (priv->starting)
+		return;
+
+	obs_data_t *settings = obs_source_get_settings(priv->source);
+
+	const carla_param_cache &params(priv->bridge->params);
+
+	if (reset) {
+		priv->paramPage = 0;
+		obs_data_set_int(settings, PROP_PARAM_PAGE, 0);
+
+		for (uint32_t i = 0; i < params.count; ++i) {
+			if (params.is_input(i))
+				param_value_to_settings(params, settings, i);
+		}
+	} else {
+		priv->paramPage = obs_data_get_int(settings, PROP_PARAM_PAGE);
+		if (priv->paramPage >= get_param_page_count(params.count))
+			priv->paramPage = 0;
 	}
 
+	carla_priv_add_plugin_props(priv, props, settings);
+
+	obs_data_release(settings);
+}
+
+static bool carla_priv_sync_properties(struct carla_priv *priv,
+				       obs_properties_t *props)
+{
+	const carla_param_cache &params(priv->bridge->params);
+	const carla_param_cache &published(priv->publishedParams);
+
 	obs_data_t *settings = obs_source_get_settings(priv->source);
 
+	// previous plugin state is not valid anymore, written again on save
+	obs_data_erase(settings, PROP_CHUNK);
+	obs_data_erase(settings, PROP_CUSTOM_DATA);
+
 	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+	bool changed = false;
 
-	for (uint32_t i = 0; i < priv->bridge.paramCount && i < MAX_PARAMS;
-	     ++i) {
-		const carla_param_data &param(priv->bridge.paramDetails[i]);
+	// settings: only touch values of parameters that changed
+	for (uint32_t i = 0; i < params.count; ++i) {
+		const param_prop_kind kind = get_param_prop_kind(params, i);
 
-		if ((param.hints & PARAMETER_IS_ENABLED) == 0)
+		if (kind == PARAM_PROP_OUTPUT)
 			continue;
 
-		obs_property_t *prop;
+		if (kind != PARAM_PROP_NONE) {
+			changed |= param_value_to_settings(params, settings, i);
+			continue;
+		}
+
 		param_index_to_name(i, pname);
 
-		if (param.hints & PARAMETER_IS_BOOLEAN) {
-			prop = obs_properties_add_bool(props, pname,
-						       param.name);
+		if (obs_data_has_user_value(settings, pname) ||
+		    obs_data_has_default_value(settings, pname)) {
+			obs_data_erase(settings, pname);
+			obs_data_unset_default_value(settings, pname);
+			changed = true;
+		}
+	}
+
+	changed |= remove_param_settings(settings, params.count);
 
-			obs_data_set_default_bool(settings, pname,
-						  carla_isEqual(param.def,
-								param.max));
+	// properties: rebuild the plugin section only if its structure changed
+	const bool hasCustomUI =
+		(priv->bridge->info.hints & PLUGIN_HAS_CUSTOM_UI) != 0;
+	const uint32_t pages = get_param_page_count(params.count);
 
-			if (reset)
-				obs_data_set_bool(settings, pname,
-						  carla_isEqual(param.value,
-								param.max));
-		} else if (param.hints & PARAMETER_IS_INTEGER) {
-			prop = obs_properties_add_int_slider(
-				props, pname, param.name, param.min, param.max,
-				param.step);
+	if (hasCustomUI != priv->publishedCustomUI ||
+	    pages != get_param_page_count(published.count) ||
+	    (priv->paramPage != 0 && priv->paramPage >= pages)) {
+		obs_properties_remove_by_name(props, PROP_SHOW_GUI);
+		obs_properties_remove_by_name(props, PROP_PARAM_PAGE);
+		remove_param_props(props);
 
-			obs_data_set_default_int(settings, pname, param.def);
+		priv->paramPage = 0;
+		obs_data_set_int(settings, PROP_PARAM_PAGE, 0);
 
-			if (param.unit.isNotEmpty())
-				obs_property_int_set_suffix(prop, param.unit);
+		carla_priv_add_plugin_props(priv, props, settings);
 
-			if (reset)
-				obs_data_set_int(settings, pname, param.value);
-		} else {
-			prop = obs_properties_add_float_slider(
-				props, pname, param.name, param.min, param.max,
-				param.step);
+		obs_data_release(settings);
+		return true;
+	}
+
+	// same structure, diff the visible page against what was published
+	const uint32_t count = std::max(params.count, published.count);
+	const uint32_t first = priv->paramPage * PARAMS_PER_PAGE;
+	const uint32_t last = std::min(count, first + PARAMS_PER_PAGE);
+	bool rebuildPage = false;
+
+	for (uint32_t i = first; i < last; ++i) {
+		if (i >= params.count) {
+			// parameters removed at the end of the page
+			param_index_to_name(i, pname);
+			obs_properties_remove_by_name(props, pname);
+			changed = true;
+			continue;
+		}
 
-			obs_data_set_default_double(settings, pname, param.def);
+		if (i >= published.count) {
+			// parameters added at the end of the page
+			carla_priv_add_param_prop(priv, props, settings, i);
+			changed = true;
+			continue;
+		}
+
+		if (param_layout_equal(params, published, i))
+			continue;
 
-			if (param.unit.isNotEmpty())
-				obs_property_float_set_suffix(prop, param.unit);
+		const param_prop_kind kind = get_param_prop_kind(params, i);
 
-			if (reset)
-				obs_data_set_double(settings, pname,
-						    param.value);
+		if (kind == PARAM_PROP_NONE &&
+		    get_param_prop_kind(published, i) == PARAM_PROP_NONE)
+			continue;
+
+		changed = true;
+
+		if (kind != get_param_prop_kind(published, i) ||
+		    !carla_priv_update_param_prop(priv, props, settings, i)) {
+			rebuildPage = true;
+			break;
 		}
+	}
 
-		obs_property_set_modified_callback2(
-			prop, carla_priv_param_changed, priv);
+	if (rebuildPage) {
+		remove_param_props(props);
+		carla_priv_add_param_props(priv, props, settings);
 	}
 
+	priv->publishedParams = params;
+
 	obs_data_release(settings);
+	return changed;
+}
+
+uint32_t carla_priv_get_output_params(struct carla_priv *priv,
+				      uint32_t *indices, float *values,
+				      uint32_t maxCount)
+{
+	// keep the last values while the UI side or a restart owns the bridge
+	std::unique_lock<std::recursive_mutex> lock(priv->bridgeMutex,
+						    std::try_to_lock);
+
+	if (lock.owns_lock() && !priv->starting) {
+		const carla_param_cache &params(priv->bridge->params);
+
+		priv->outputIndices.clear();
+		priv->outputValues.clear();
+
+		for (uint32_t i = 0; i < params.count; ++i) {
+			if ((params.hints[i] & PARAMETER_IS_ENABLED) == 0)
+				continue;
+			if (!params.outputs[i])
+				continue;
+
+			priv->outputIndices.push_back(i);
+			priv->outputValues.push_back(params.values[i]);
+		}
+	}
+
+	const uint32_t count = std::min<uint32_t>(
+		maxCount, static_cast<uint32_t>(priv->outputIndices.size()));
+
+	for (uint32_t i = 0; i < count; ++i) {
+		indices[i] = priv->outputIndices[i];
+		values[i] = priv->outputValues[i];
+	}
+
+	return count;
 }
 
 // ----------------------------------------------------------------------------
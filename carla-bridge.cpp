@@ -17,7 +17,36 @@
 #include "CarlaMacUtils.hpp"
 #endif
 
+#include <algorithm>
+#include <cerrno>
 #include <ctime>
+#include <mutex>
+
+#ifdef CARLA_OS_WIN
+#include <windows.h>
+#else
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifndef CARLA_OS_WIN
+#include <spawn.h>
+#endif
+
+#ifdef CARLA_OS_MAC
+// `environ` is not directly available to shared libraries on macOS
+#include <crt_externs.h>
+#define environ (*_NSGetEnviron())
+#endif
+
+#ifdef CARLA_OS_LINUX
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
@@ -50,6 +79,25 @@ static bool isIntel64BitPlugin(const char *const pluginBundle)
 }
 #endif
 
+// ----------------------------------------------------------------------------
+// location for bulk state transfers (chunks and big custom data values)
+// the bridge protocol exchanges these through files, so we place them on a
+// memory-backed filesystem where possible, avoiding disk I/O for big states
+
+static const QString &getBulkTransferPath()
+{
+	static const QString path = []() -> QString {
+#ifdef CARLA_OS_LINUX
+		const QFileInfo shmInfo(QStringLiteral("/dev/shm"));
+		if (shmInfo.isDir() && shmInfo.isWritable())
+			return shmInfo.absoluteFilePath();
+#endif
+		return QDir::tempPath();
+	}();
+
+	return path;
+}
+
 // ----------------------------------------------------------------------------
 // utility class for reading and deleting incoming bridge text in RAII fashion
 
@@ -82,10 +130,444 @@ struct BridgeTextReader {
 	CARLA_DECLARE_NON_COPYABLE(BridgeTextReader)
 };
 
+// ----------------------------------------------------------------------------
+// parameter cache implementation
+
+void carla_param_cache::resize(const uint32_t newCount)
+{
+	count = newCount;
+	hints.assign(newCount, 0);
+	values.assign(newCount, 0.f);
+	defs.assign(newCount, 0.f);
+	mins.assign(newCount, 0.f);
+	maxs.assign(newCount, 1.f);
+	steps.assign(newCount, 0.01f);
+	names.assign(newCount, 0);
+	units.assign(newCount, 0);
+	outputs.assign(newCount, false);
+
+	// reserve enough for typical names and units upfront
+	strings.assign(1, '\0');
+	strings.reserve(newCount * 32);
+	uniqueUnits.clear();
+}
+
+// ----------------------------------------------------------------------------
+// custom data store implementation
+
+// compact arena once this much of it is unused
+static constexpr const size_t kCustomDataMinGarbage = 64 * 1024;
+
+static uint64_t custom_data_hash(const char *type, const char *key) noexcept
+{
+	// FNV-1a, type and key separated by a null byte
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (; *type != '\0'; ++type) {
+		hash ^= static_cast<uint8_t>(*type);
+		hash *= 1099511628211ULL;
+	}
+
+	hash *= 1099511628211ULL;
+
+	for (; *key != '\0'; ++key) {
+		hash ^= static_cast<uint8_t>(*key);
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+carla_custom_data_store::item
+carla_custom_data_store::get(const uint32_t index) const noexcept
+{
+	const entry &e(entries[index]);
+	const char *const base = arena.data();
+
+	return {base + e.type, base + e.key, base + e.value, e.valueLen};
+}
+
+uint32_t carla_custom_data_store::set(const char *const type,
+				      const char *const key,
+				      const char *const value)
+{
+	const uint64_t hash = custom_data_hash(type, key);
+	const uint32_t valueLen = static_cast<uint32_t>(std::strlen(value));
+
+	uint32_t index = find(hash, type, key);
+
+	if (index != UINT32_MAX) {
+		entry &e(entries[index]);
+
+		if (e.valueLen == valueLen &&
+		    std::memcmp(arena.data() + e.value, value, valueLen) == 0)
+			return index;
+
+		if (valueLen <= e.valueCapacity) {
+			std::memcpy(arena.data() + e.value, value,
+				    valueLen + 1);
+		} else {
+			garbage += e.valueCapacity + 1;
+			e.value = store_string(value, valueLen);
+			e.valueCapacity = valueLen;
+		}
+
+		e.valueLen = valueLen;
+		e.dirty = true;
+
+		if (garbage > kCustomDataMinGarbage &&
+		    garbage > arena.size() / 2)
+			compact();
+
+		return index;
+	}
+
+	// keep hash table load under 50%
+	if ((entries.size() + 1) * 2 > buckets.size()) {
+		buckets.assign(buckets.empty() ? 64 : buckets.size() * 2,
+			       UINT32_MAX);
+
+		for (uint32_t i = 0, count = this->count(); i < count; ++i)
+			insert_bucket(i);
+	}
+
+	entry e;
+	e.hash = hash;
+	e.type = store_string(type, static_cast<uint32_t>(std::strlen(type)));
+	e.key = store_string(key, static_cast<uint32_t>(std::strlen(key)));
+	e.value = store_string(value, valueLen);
+	e.valueLen = e.valueCapacity = valueLen;
+	e.dirty = true;
+
+	index = count();
+	entries.push_back(e);
+	insert_bucket(index);
+
+	return index;
+}
+
+bool carla_custom_data_store::is_dirty(const uint32_t index) const noexcept
+{
+	return entries[index].dirty;
+}
+
+void carla_custom_data_store::set_synced(const uint32_t index) noexcept
+{
+	entries[index].dirty = false;
+}
+
+void carla_custom_data_store::mark_all_dirty() noexcept
+{
+	for (entry &e : entries)
+		e.dirty = true;
+}
+
+void carla_custom_data_store::clear() noexcept
+{
+	arena.clear();
+	entries.clear();
+	buckets.clear();
+	garbage = 0;
+}
+
+uint32_t carla_custom_data_store::find(const uint64_t hash,
+				       const char *const type,
+				       const char *const key) const noexcept
+{
+	if (buckets.empty())
+		return UINT32_MAX;
+
+	const size_t mask = buckets.size() - 1;
+
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		const uint32_t index = buckets[i];
+
+		if (index == UINT32_MAX)
+			return UINT32_MAX;
+
+		const entry &e(entries[index]);
+
+		if (e.hash == hash &&
+		    std::strcmp(arena.data() + e.key, key) == 0 &&
+		    std::strcmp(arena.data() + e.type, type) == 0)
+			return index;
+	}
+}
+
+uint32_t carla_custom_data_store::store_string(const char *const str,
+					       const uint32_t len)
+{
+	const uint32_t offset = static_cast<uint32_t>(arena.size());
+	arena.insert(arena.end(), str, str + len + 1);
+	return offset;
+}
+
+void carla_custom_data_store::insert_bucket(const uint32_t index)
+{
+	const size_t mask = buckets.size() - 1;
+
+	size_t i = entries[index].hash & mask;
+	while (buckets[i] != UINT32_MAX)
+		i = (i + 1) & mask;
+
+	buckets[i] = index;
+}
+
+void carla_custom_data_store::compact()
+{
+	std::vector<char> oldArena;
+	oldArena.swap(arena);
+	arena.reserve(oldArena.size() - garbage);
+
+	for (entry &e : entries) {
+		const char *const base = oldArena.data();
+
+		e.type = store_string(
+			base + e.type,
+			static_cast<uint32_t>(std::strlen(base + e.type)));
+		e.key = store_string(
+			base + e.key,
+			static_cast<uint32_t>(std::strlen(base + e.key)));
+		e.value = store_string(base + e.value, e.valueLen);
+		e.valueCapacity = e.valueLen;
+	}
+
+	garbage = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Windows plugin bridges through Wine
+// starting wineserver takes seconds, so we keep one running per prefix
+
+#ifndef CARLA_OS_WIN
+// plugins installed inside a prefix run on it, look for its "dosdevices"
+static QString findWinePrefix(const QString &filename,
+			      const int recursionLimit = 10)
+{
+	if (recursionLimit == 0 || filename.length() < 5)
+		return {};
+
+	const int lastSep = filename.lastIndexOf('/');
+	if (lastSep < 0)
+		return {};
+
+	const QString path(filename.left(lastSep));
+
+	if (QFileInfo(path + "/dosdevices").isDir())
+		return path;
+
+	return findWinePrefix(path, recursionLimit - 1);
+}
+
+static QString getDefaultWinePrefix()
+{
+	const char *const envWinePrefix = std::getenv("WINEPREFIX");
+
+	if (envWinePrefix != nullptr && envWinePrefix[0] != '\0')
+		return QString::fromLocal8Bit(envWinePrefix);
+
+	return QDir::homePath() + "/.wine";
+}
+
+static std::mutex s_wine_mutex;
+static std::vector<std::pair<QString, pid_t>> s_wine_servers;
+
+// collect servers that exited, must be called with `s_wine_mutex` held
+// a server exits right away if another one already runs on its prefix,
+// the prefix is kept with a zero pid so we do not try again
+static void reap_wine_servers()
+{
+	for (std::pair<QString, pid_t> &server : s_wine_servers) {
+		if (server.second != 0 &&
+		    waitpid(server.second, nullptr, WNOHANG) != 0)
+			server.second = 0;
+	}
+}
+
+// start a persistent wineserver for a prefix, unless we already did
+// the server runs in foreground as our child, so it can be stopped when
+// the module unloads instead of outliving OBS
+static void start_wine_server(const QString &prefix)
+{
+	// do not create new prefixes just for warming them up
+	if (!QFileInfo(prefix + "/dosdevices").isDir())
+		return;
+
+	const std::lock_guard<std::mutex> lock(s_wine_mutex);
+
+	reap_wine_servers();
+
+	for (const std::pair<QString, pid_t> &server : s_wine_servers) {
+		if (server.first == prefix)
+			return;
+	}
+
+	std::vector<QByteArray> environment;
+	environment.push_back("WINEPREFIX=" + prefix.toLocal8Bit());
+
+	for (char **env = environ; *env != nullptr; ++env) {
+		if (std::strncmp(*env, "WINEPREFIX=", 11) != 0)
+			environment.push_back(QByteArray(*env));
+	}
+
+	std::vector<char *> envp;
+	envp.reserve(environment.size() + 1);
+	for (QByteArray &env : environment)
+		envp.push_back(env.data());
+	envp.push_back(nullptr);
+
+	char wineserver[] = "wineserver";
+	char foreground[] = "-f";
+	char persistent[] = "-p";
+	char *argv[] = {wineserver, foreground, persistent, nullptr};
+
+	pid_t pid;
+	if (posix_spawnp(&pid, wineserver, nullptr, nullptr, argv,
+			 envp.data()) != 0) {
+		blog(LOG_DEBUG,
+		     "[" CARLA_MODULE_ID "] wineserver not available");
+		return;
+	}
+
+	blog(LOG_INFO, "[" CARLA_MODULE_ID "] started wineserver for %s",
+	     prefix.toUtf8().constData());
+
+	s_wine_servers.emplace_back(prefix, pid);
+
+	// collect it now if it found another server running already
+	reap_wine_servers();
+}
+#endif
+
+void carla_bridge_module_load()
+{
+#ifndef CARLA_OS_WIN
+	const QString binPath(QString::fromUtf8(get_carla_bin_path()));
+
+	// only worth it if we can run Windows plugins at all
+	if (QFileInfo(binPath + "/carla-bridge-win64.exe").exists() ||
+	    QFileInfo(binPath + "/carla-bridge-win32.exe").exists())
+		start_wine_server(getDefaultWinePrefix());
+#endif
+}
+
+void carla_bridge_module_unload()
+{
+#ifndef CARLA_OS_WIN
+	const std::lock_guard<std::mutex> lock(s_wine_mutex);
+
+	// persistent servers stay until told to quit
+	reap_wine_servers();
+
+	for (const std::pair<QString, pid_t> &server : s_wine_servers) {
+		if (server.second == 0)
+			continue;
+
+		kill(server.second, SIGTERM);
+		waitpid(server.second, nullptr, 0);
+	}
+
+	s_wine_servers.clear();
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// fault in all pages of a shared memory region now, so the audio thread does
+// not take page faults on the first blocks after activation
+
+static void prefault_memory(void *data, size_t size, bool lock)
+{
+	if (data == nullptr || size == 0)
+		return;
+
+	// write back the same value, contents might be in use already
+	volatile char *const bytes = static_cast<volatile char *>(data);
+
+	for (size_t i = 0; i < size; i += 4096)
+		bytes[i] = bytes[i];
+
+	if (!lock)
+		return;
+
+#ifdef CARLA_OS_WIN
+	// locked pages count against the working set, make room for them
+	SIZE_T minSize, maxSize;
+	if (GetProcessWorkingSetSize(GetCurrentProcess(), &minSize, &maxSize))
+		SetProcessWorkingSetSize(GetCurrentProcess(), minSize + size,
+					 std::max(maxSize, minSize + size));
+
+	if (!VirtualLock(data, size))
+#else
+	if (mlock(data, size) != 0)
+#endif
+		blog(LOG_WARNING,
+		     "[" CARLA_MODULE_ID "] failed to lock %u KiB of memory",
+		     static_cast<uint>(size / 1024));
+}
+
+#ifndef CARLA_OS_LINUX
+// report policy settings this platform cannot apply, once per module
+static void warn_unsupported_policy(const carla_bridge_policy &policy)
+{
+	static std::atomic<bool> warned{false};
+
+#ifdef CARLA_OS_WIN
+	const bool unsupported = policy.numaNode >= 0;
+#else
+	const bool unsupported = policy.cpus.isNotEmpty() ||
+				 policy.numaNode >= 0;
+#endif
+
+	if (unsupported && !warned.exchange(true))
+		blog(LOG_WARNING, "[" CARLA_MODULE_ID "] plugin process CPU or"
+				  " NUMA placement is not supported on this"
+				  " platform, ignoring it");
+}
+#endif
+
 // ----------------------------------------------------------------------------
 // custom bridge process implementation
 
-BridgeProcess::BridgeProcess(const char *const shmIds)
+#if defined(CARLA_OS_LINUX) || defined(CARLA_OS_WIN)
+// parse a CPU list in taskset format, e.g. "0,2-3"
+// `addCpu` is called for each listed CPU, it returns false if out of range
+template <typename AddCpu>
+static bool parse_cpu_list(const char *list, AddCpu addCpu)
+{
+	bool any = false;
+
+	while (*list != '\0') {
+		char *end;
+		const long first = std::strtol(list, &end, 10);
+		long last = first;
+
+		if (end == list || first < 0)
+			return false;
+
+		if (*end == '-') {
+			list = end + 1;
+			last = std::strtol(list, &end, 10);
+
+			if (end == list || last < first)
+				return false;
+		}
+
+		for (long cpu = first; cpu <= last && addCpu(cpu); ++cpu)
+			any = true;
+
+		while (*end == ',' || *end == ' ')
+			++end;
+
+		list = end;
+	}
+
+	return any;
+}
+#endif
+
+#ifdef _WIN32
+BridgeProcess::BridgeProcess(const char *const shmIds,
+			     const carla_bridge_policy &policy)
 {
 	// move object to the correct/expected thread
 	moveToThread(qApp->thread());
@@ -93,19 +575,117 @@ BridgeProcess::BridgeProcess(const char *const shmIds)
 	// setup environment for client side
 	QProcessEnvironment env(QProcessEnvironment::systemEnvironment());
 	env.insert("ENGINE_BRIDGE_SHM_IDS", shmIds);
+
+	// bridge writes its chunk and big value files into its temp dir
+	env.insert("TMPDIR", getBulkTransferPath());
 	setProcessEnvironment(env);
+
+	if (policy.cpus.isNotEmpty() &&
+	    !parse_cpu_list(policy.cpus, [this](long cpu) {
+		    if (cpu >= static_cast<long>(sizeof(cpuMask) * 8))
+			    return false;
+		    cpuMask |= static_cast<uintptr_t>(1) << cpu;
+		    return true;
+	    })) {
+		cpuMask = 0;
+		blog(LOG_WARNING,
+		     "[" CARLA_MODULE_ID "] invalid CPU list \"%s\"",
+		     policy.cpus.buffer());
+	}
+
+	nice = policy.nice;
+
+	warn_unsupported_policy(policy);
 }
 
-void BridgeProcess::start()
+bool BridgeProcess::launch(const QString &program,
+			   const QStringList &arguments)
+{
+	setProgram(program);
+	setArguments(arguments);
+
+	// start process on main thread
+	QMetaObject::invokeMethod(this, "startOnMainThread");
+
+	// polling status instead of waiting on the process directly means
+	// this also works from a background thread
+	const uint64_t spawn_time = carla_gettime_ms();
+
+	while (startStatus == START_PENDING &&
+	       carla_gettime_ms() - spawn_time < 6000)
+		carla_msleep(5);
+
+	return startStatus == START_OK;
+}
+
+bool BridgeProcess::isRunning() const
+{
+	return state() == QProcess::Running;
+}
+
+bool BridgeProcess::hasCrashed() const
+{
+	return exitStatus() == QProcess::CrashExit;
+}
+
+void BridgeProcess::stop()
+{
+	// let Qt do the final cleanup on the main thread
+	QMetaObject::invokeMethod(this, "stopOnMainThread");
+}
+
+void BridgeProcess::startOnMainThread()
 {
 	// pass-through all bridge output
 	setInputChannelMode(QProcess::ForwardedInputChannel);
 	setProcessChannelMode(QProcess::ForwardedChannels);
 	QProcess::start(QIODevice::Unbuffered | QIODevice::ReadOnly);
+
+	// this runs on the main thread, where waiting on QProcess is valid
+	const bool started = waitForStarted(5000);
+
+	if (started)
+		applyPolicy();
+
+	startStatus = started ? START_OK : START_FAILED;
 }
 
-// NOTE: process instance cannot be used after this!
-void BridgeProcess::stop()
+void BridgeProcess::applyPolicy()
+{
+	if (cpuMask == 0 && nice == 0)
+		return;
+
+	const HANDLE handle = OpenProcess(PROCESS_SET_INFORMATION, FALSE,
+					  static_cast<DWORD>(processId()));
+	if (handle == nullptr)
+		return;
+
+	if (cpuMask != 0 &&
+	    !SetProcessAffinityMask(handle, static_cast<DWORD_PTR>(cpuMask)))
+		blog(LOG_WARNING,
+		     "[" CARLA_MODULE_ID "] failed to set bridge CPU affinity");
+
+	// closest priority class for a nice level
+	if (nice != 0) {
+		DWORD priorityClass;
+		if (nice <= -15)
+			priorityClass = HIGH_PRIORITY_CLASS;
+		else if (nice < 0)
+			priorityClass = ABOVE_NORMAL_PRIORITY_CLASS;
+		else if (nice >= 15)
+			priorityClass = IDLE_PRIORITY_CLASS;
+		else
+			priorityClass = BELOW_NORMAL_PRIORITY_CLASS;
+
+		if (!SetPriorityClass(handle, priorityClass))
+			blog(LOG_WARNING, "[" CARLA_MODULE_ID "]"
+					  " failed to set bridge priority");
+	}
+
+	CloseHandle(handle);
+}
+
+void BridgeProcess::stopOnMainThread()
 {
 	if (state() != QProcess::NotRunning) {
 		terminate();
@@ -124,44 +704,334 @@ void BridgeProcess::stop()
 
 	deleteLater();
 }
+#else
+BridgeProcess::BridgeProcess(const char *const shmIds,
+			     const carla_bridge_policy &policy)
+{
+	// setup environment for client side
+	environment.push_back(QByteArray("ENGINE_BRIDGE_SHM_IDS=") + shmIds);
 
-// ----------------------------------------------------------------------------
+	// bridge writes its chunk and big value files into its temp dir
+	environment.push_back("TMPDIR=" + getBulkTransferPath().toLocal8Bit());
 
-bool carla_bridge::init(uint32_t maxBufferSize, double sampleRate)
+	for (char **env = environ; *env != nullptr; ++env) {
+		if (std::strncmp(*env, "ENGINE_BRIDGE_SHM_IDS=", 22) == 0 ||
+		    std::strncmp(*env, "TMPDIR=", 7) == 0)
+			continue;
+
+		environment.push_back(QByteArray(*env));
+	}
+
+	nice = policy.nice;
+
+#ifdef CARLA_OS_LINUX
+	if (policy.cpus.isNotEmpty()) {
+		CPU_ZERO(&cpuMask);
+
+		hasCpuMask = parse_cpu_list(policy.cpus, [this](long cpu) {
+			if (cpu >= CPU_SETSIZE)
+				return false;
+			CPU_SET(cpu, &cpuMask);
+			return true;
+		});
+
+		if (!hasCpuMask)
+			blog(LOG_WARNING,
+			     "[" CARLA_MODULE_ID "] invalid CPU list \"%s\"",
+			     policy.cpus.buffer());
+	}
+
+	if (policy.numaNode >= 0 &&
+	    policy.numaNode < static_cast<int>(sizeof(numaMask) * 8))
+		numaMask = 1UL << policy.numaNode;
+
+	realtime = policy.realtime;
+#else
+	warn_unsupported_policy(policy);
+#endif
+}
+
+BridgeProcess::~BridgeProcess()
 {
-	// add entropy to rand calls, used for finding unused paths
-	std::srand(static_cast<uint>(std::time(nullptr)));
+	if (pidfd >= 0)
+		close(pidfd);
+}
 
-	// initialize the several communication channels
-	if (!audiopool.initializeServer()) {
-		blog(LOG_WARNING,
-		     "[" CARLA_MODULE_ID "]"
-		     " Failed to initialize shared memory audio pool");
+bool BridgeProcess::launch(const QString &program,
+			   const QStringList &arguments)
+{
+	// everything the child needs must be prepared before it is created
+	std::vector<QByteArray> args;
+	args.reserve(static_cast<size_t>(arguments.size()) + 1);
+	args.push_back(program.toLocal8Bit());
+	for (const QString &arg : arguments)
+		args.push_back(arg.toLocal8Bit());
+
+	std::vector<char *> argv;
+	argv.reserve(args.size() + 1);
+	for (QByteArray &arg : args)
+		argv.push_back(arg.data());
+	argv.push_back(nullptr);
+
+	std::vector<char *> envp;
+	envp.reserve(environment.size() + 1);
+	for (QByteArray &env : environment)
+		envp.push_back(env.data());
+	envp.push_back(nullptr);
+
+#ifdef CARLA_OS_LINUX
+	// vfork keeps the cost of starting a process independent of how much
+	// memory OBS uses, the child only does plain syscalls until exec
+	volatile int execError = 0;
+
+	// the child shares memory with OBS, none of its signal handlers may
+	// run there, so all signals stay blocked until the child has reset
+	// them, same as glibc's posix_spawn
+	sigset_t allSignals, oldSignals;
+	sigfillset(&allSignals);
+	pthread_sigmask(SIG_BLOCK, &allSignals, &oldSignals);
+
+	const pid_t ret = vfork();
+
+	if (ret == 0) {
+		struct sigaction dfl = {};
+		dfl.sa_handler = SIG_DFL;
+
+		// ignored signals stay ignored, as with a regular exec
+		for (int sig = 1; sig < _NSIG; ++sig) {
+			struct sigaction sa;
+			if (sigaction(sig, nullptr, &sa) == 0 &&
+			    sa.sa_handler != SIG_IGN && sa.sa_handler != SIG_DFL)
+				sigaction(sig, &dfl, nullptr);
+		}
+
+		pthread_sigmask(SIG_SETMASK, &oldSignals, nullptr);
+
+		applyPolicy();
+		execvpe(argv[0], argv.data(), envp.data());
+		execError = errno;
+		_exit(127);
+	}
+
+	pthread_sigmask(SIG_SETMASK, &oldSignals, nullptr);
+
+	if (ret < 0)
+		return false;
+
+	pid = ret;
+
+	if (execError != 0) {
+		reap(true);
 		return false;
 	}
 
-	if (!rtClientCtrl.initializeServer()) {
-		blog(LOG_WARNING, "[" CARLA_MODULE_ID "]"
-				  " Failed to initialize RT client control");
-		goto fail1;
+#ifdef SYS_pidfd_open
+	// fails on older kernels, plain waitpid polling is used then
+	pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#endif
+#else
+	if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(),
+			 envp.data()) != 0) {
+		pid = -1;
+		return false;
 	}
 
-	if (!nonRtClientCtrl.initializeServer()) {
+	// posix_spawn has no nice attribute, apply it right after
+	if (nice != 0 && setpriority(PRIO_PROCESS, pid, nice) != 0)
 		blog(LOG_WARNING,
-		     "[" CARLA_MODULE_ID "]"
-		     " Failed to initialize Non-RT client control");
-		goto fail2;
+		     "[" CARLA_MODULE_ID "] failed to set bridge nice level");
+#endif
+
+	return true;
+}
+
+bool BridgeProcess::isRunning()
+{
+	if (pid <= 0)
+		return false;
+
+	// cheap check first, pidfd becomes readable once the process exits
+	if (pidfd >= 0) {
+		struct pollfd pfd = {pidfd, POLLIN, 0};
+		if (poll(&pfd, 1, 0) == 0)
+			return true;
 	}
 
-	if (!nonRtServerCtrl.initializeServer()) {
-		blog(LOG_WARNING,
-		     "[" CARLA_MODULE_ID "]"
-		     " Failed to initialize Non-RT server control");
-		goto fail3;
+	return !reap(false);
+}
+
+void BridgeProcess::stop()
+{
+	if (isRunning()) {
+		kill(pid, SIGTERM);
+
+		if (waitForExit(2000)) {
+			blog(LOG_DEBUG, "[" CARLA_MODULE_ID "]"
+					" bridge auto-closed successfully");
+		} else {
+			blog(LOG_INFO,
+			     "[" CARLA_MODULE_ID "]"
+			     " bridge refused to close, force kill now");
+			kill(pid, SIGKILL);
+			reap(true);
+		}
 	}
 
-	// resize audiopool data to be as large as needed
-	audiopool.resize(maxBufferSize, MAX_AV_PLANES, MAX_AV_PLANES);
+	delete this;
+}
+
+void BridgeProcess::setEnvironmentValue(const char *const name,
+					const QByteArray &value)
+{
+	const QByteArray prefix(QByteArray(name) + '=');
+
+	for (QByteArray &env : environment) {
+		if (env.startsWith(prefix)) {
+			env = prefix + value;
+			return;
+		}
+	}
+
+	environment.push_back(prefix + value);
+}
+
+#ifdef CARLA_OS_LINUX
+void BridgeProcess::applyPolicy()
+{
+	// threads created later by the bridge inherit all of these
+	if (hasCpuMask)
+		sched_setaffinity(0, sizeof(cpuMask), &cpuMask);
+
+	if (nice != 0)
+		setpriority(PRIO_PROCESS, 0, nice);
+
+	// the bridge asks for realtime priority on its audio thread by itself,
+	// raising the soft limit lets that succeed where the user is allowed to
+	if (realtime) {
+		struct rlimit limit;
+		if (getrlimit(RLIMIT_RTPRIO, &limit) == 0) {
+			limit.rlim_cur = limit.rlim_max;
+			setrlimit(RLIMIT_RTPRIO, &limit);
+		}
+	}
+
+	if (numaMask != 0)
+		syscall(SYS_set_mempolicy, MPOL_BIND, &numaMask,
+			sizeof(numaMask) * 8 + 1);
+}
+#endif
+
+bool BridgeProcess::reap(const bool block)
+{
+	if (pid <= 0)
+		return true;
+
+	int status = 0;
+	pid_t ret;
+
+	do {
+		ret = waitpid(pid, &status, block ? 0 : WNOHANG);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret == 0)
+		return false;
+
+	// ECHILD means someone else collected it already, treat as a crash
+	crashed = ret < 0 || WIFSIGNALED(status) ||
+		  (WIFEXITED(status) && WEXITSTATUS(status) != 0);
+	pid = -1;
+
+	if (pidfd >= 0) {
+		close(pidfd);
+		pidfd = -1;
+	}
+
+	return true;
+}
+
+bool BridgeProcess::waitForExit(const uint msecs)
+{
+	const uint64_t start_time = carla_gettime_ms();
+
+	while (!reap(false)) {
+		const uint64_t elapsed = carla_gettime_ms() - start_time;
+
+		if (elapsed >= msecs)
+			return false;
+
+		if (pidfd >= 0) {
+			struct pollfd pfd = {pidfd, POLLIN, 0};
+			poll(&pfd, 1, static_cast<int>(msecs - elapsed));
+		} else {
+			carla_msleep(5);
+		}
+	}
+
+	return true;
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+bool carla_bridge::init(uint32_t maxBufferSize, double sampleRate)
+{
+	// shared memory channels are kept between bridge restarts,
+	// only the first init for each instance needs to create them
+	if (!channelsReady) {
+		// add entropy to rand calls, used for finding unused paths
+		// seeding only once, as reseeding with the same time would make
+		// instances created within one second retry the same names
+		static const bool seeded = []() {
+			std::srand(static_cast<uint>(
+				std::time(nullptr) ^ carla_gettime_us() ^
+				QCoreApplication::applicationPid()));
+			return true;
+		}();
+		(void)seeded;
+
+		// initialize the several communication channels
+		if (!audiopool.initializeServer()) {
+			blog(LOG_WARNING,
+			     "[" CARLA_MODULE_ID "]"
+			     " Failed to initialize shared memory audio pool");
+			return false;
+		}
+
+		if (!rtClientCtrl.initializeServer()) {
+			blog(LOG_WARNING,
+			     "[" CARLA_MODULE_ID "]"
+			     " Failed to initialize RT client control");
+			goto fail1;
+		}
+
+		if (!nonRtClientCtrl.initializeServer()) {
+			blog(LOG_WARNING,
+			     "[" CARLA_MODULE_ID "]"
+			     " Failed to initialize Non-RT client control");
+			goto fail2;
+		}
+
+		if (!nonRtServerCtrl.initializeServer()) {
+			blog(LOG_WARNING,
+			     "[" CARLA_MODULE_ID "]"
+			     " Failed to initialize Non-RT server control");
+			goto fail3;
+		}
+
+		channelsReady = true;
+
+		prefault_memory(rtClientCtrl.data, sizeof(BridgeRtClientData),
+				policy.lockMemory);
+		prefault_memory(nonRtClientCtrl.data,
+				sizeof(BridgeNonRtClientData),
+				policy.lockMemory);
+		prefault_memory(nonRtServerCtrl.data,
+				sizeof(BridgeNonRtServerData),
+				policy.lockMemory);
+	}
+
+	bufferSize = maxBufferSize;
+	resizeAudioPool();
 
 	// clear realtime data
 	rtClientCtrl.data->procFlags = 0;
@@ -203,7 +1073,9 @@ bool carla_bridge::init(uint32_t maxBufferSize, double sampleRate)
 	rtClientCtrl.writeUInt(maxBufferSize);
 	rtClientCtrl.commitWrite();
 
-	bufferSize = maxBufferSize;
+	processPending = false;
+	reset_delay();
+
 	blog(LOG_DEBUG, "[" CARLA_MODULE_ID "] initialized with %u buffer size",
 	     bufferSize);
 
@@ -220,10 +1092,15 @@ fail1:
 	return false;
 }
 
-void carla_bridge::cleanup(const bool clearPluginData)
+void carla_bridge::cleanup(const bool clearPluginData,
+			   const bool keepChannels)
 {
 	// signal to stop processing audio
 	ready = false;
+	crashed = false;
+	saveTime = 0;
+	wait_audio_idle();
+	finish_pending_process();
 
 	// stop bridge process
 	if (childprocess != nullptr) {
@@ -232,7 +1109,7 @@ void carla_bridge::cleanup(const bool clearPluginData)
 		childprocess = nullptr;
 
 		// if process is running, ask nicely for it to close
-		if (proc->state() != QProcess::NotRunning) {
+		if (proc->isRunning()) {
 			{
 				const CarlaMutexLocker cml(
 					nonRtClientCtrl.mutex);
@@ -257,27 +1134,30 @@ void carla_bridge::cleanup(const bool clearPluginData)
 				wait("stopping", 3000);
 		} else {
 			// log warning in case plugin process crashed
-			if (proc->exitStatus() == QProcess::CrashExit) {
+			if (proc->hasCrashed()) {
 				blog(LOG_WARNING,
 				     "[" CARLA_MODULE_ID "]"
 				     " carla_bridge::cleanup() - bridge crashed");
 			}
 		}
 
-		// let Qt do the final cleanup on the main thread
-		QMetaObject::invokeMethod(proc, "stop");
+		proc->stop();
 	}
 
-	// cleanup shared memory bits
-	nonRtServerCtrl.clear();
-	nonRtClientCtrl.clear();
-	rtClientCtrl.clear();
-	audiopool.clear();
+	// cleanup shared memory bits, unless kept for the next `init()`
+	if (channelsReady && !keepChannels) {
+		channelsReady = false;
+		nonRtServerCtrl.clear();
+		nonRtClientCtrl.clear();
+		rtClientCtrl.clear();
+		audiopool.clear();
+	}
 
 	// clear cached plugin data if requested
 	if (clearPluginData) {
 		info.clear();
 		chunk.clear();
+		chunkDirty = true;
 		clear_custom_data();
 	}
 }
@@ -290,6 +1170,9 @@ bool carla_bridge::start(const BinaryType btype, const PluginType ptype,
 	CARLA_SAFE_ASSERT_RETURN(btype != BINARY_NONE, false);
 	CARLA_SAFE_ASSERT_RETURN(ptype != PLUGIN_NONE, false);
 
+	// shared memory channels come from `init()`
+	CARLA_SAFE_ASSERT_RETURN(channelsReady, false);
+
 	// find path to bridge binary
 	QString bridgeBinary(QString::fromUtf8(get_carla_bin_path()));
 
@@ -317,7 +1200,16 @@ bool carla_bridge::start(const BinaryType btype, const PluginType ptype,
 		}
 	}
 
-	if (bridgeBinary.isEmpty() || !QFileInfo(bridgeBinary).isExecutable()) {
+#ifndef CARLA_OS_WIN
+	// Windows bridges run through Wine, their exe does not need exec bits
+	const bool needsWine = btype == BINARY_WIN32 || btype == BINARY_WIN64;
+#else
+	const bool needsWine = false;
+#endif
+
+	if (bridgeBinary.isEmpty() ||
+	    !(needsWine ? QFileInfo(bridgeBinary).isFile()
+			: QFileInfo(bridgeBinary).isExecutable())) {
 		blog(LOG_ERROR,
 		     "[" CARLA_MODULE_ID "]"
 		     " Cannot load plugin, the required plugin bridge is not available");
@@ -344,10 +1236,33 @@ bool carla_bridge::start(const BinaryType btype, const PluginType ptype,
 	std::strncpy(shmIdsStr + 18, &nonRtServerCtrl.filename[len - 6], 6);
 
 	// create bridge process and setup arguments
-	BridgeProcess *proc = new BridgeProcess(shmIdsStr);
+	BridgeProcess *proc = new BridgeProcess(shmIdsStr, policy);
+
+	bindSharedMemory();
 
 	QStringList arguments;
 
+#ifndef CARLA_OS_WIN
+	winePrefix.clear();
+
+	// start with "wine" if needed
+	if (needsWine) {
+		winePrefix = findWinePrefix(QString::fromUtf8(filename));
+
+		if (winePrefix.isEmpty())
+			winePrefix = getDefaultWinePrefix();
+
+		// usually running already since module load
+		start_wine_server(winePrefix);
+
+		proc->setEnvironmentValue("WINEPREFIX",
+					  winePrefix.toLocal8Bit());
+
+		arguments.append(bridgeBinary);
+		bridgeBinary = "wine";
+	}
+#endif
+
 #if defined(CARLA_OS_MAC) && defined(__aarch64__)
 	// see if this binary needs special help (x86_64 plugins under arm64 systems)
 	switch (ptype) {
@@ -385,24 +1300,15 @@ bool carla_bridge::start(const BinaryType btype, const PluginType ptype,
 	// arg 4: uniqueId
 	arguments.append(QString::number(uniqueId));
 
-	proc->setProgram(bridgeBinary);
-	proc->setArguments(arguments);
-
 	blog(LOG_INFO,
 	     "[" CARLA_MODULE_ID "]"
 	     " Starting plugin bridge, command is:\n%s \"%s\" \"%s\" \"%s\" " P_INT64,
 	     bridgeBinary.toUtf8().constData(), getPluginTypeAsString(ptype),
 	     filename, label, uniqueId);
 
-	// start process on main thread
-	QMetaObject::invokeMethod(proc, "start");
-
-	// check if it started correctly
-	const bool started = proc->waitForStarted(5000);
-
-	if (!started) {
+	if (!proc->launch(bridgeBinary, arguments)) {
 		blog(LOG_INFO, "[" CARLA_MODULE_ID "] failed!");
-		QMetaObject::invokeMethod(proc, "stop");
+		proc->stop();
 		return false;
 	}
 
@@ -415,10 +1321,13 @@ bool carla_bridge::start(const BinaryType btype, const PluginType ptype,
 
 	const uint64_t start_time = carla_gettime_ms();
 
-	// NOTE: we cannot rely on `proc->state() == QProcess::Running` here
-	// as Qt only updates QProcess state on main thread
+	// NOTE: we cannot rely on `proc->isRunning()` here, on Windows
+	// Qt only updates QProcess state on main thread
 	while (proc != nullptr && !ready) {
-		carla_msleep(5);
+		// keep draining while the bridge is sending plugin details,
+		// so it never has to wait for free space in the ring buffer
+		if (!nonRtServerCtrl.isDataAvailableForReading())
+			carla_msleep(5);
 
 		// timeout after 5s
 		if (carla_gettime_ms() - start_time > 5000)
@@ -430,10 +1339,31 @@ bool carla_bridge::start(const BinaryType btype, const PluginType ptype,
 	if (!ready) {
 		blog(LOG_WARNING,
 		     "[" CARLA_MODULE_ID "] failed to start plugin bridge");
-		QMetaObject::invokeMethod(proc, "stop");
+		proc->stop();
 		return false;
 	}
 
+	// `readMessages()` published `ready` already, keep the audio thread
+	// out until the audio pool has its final size
+	ready = false;
+	wait_audio_idle();
+
+	// now that plugin I/O is known, drop the audio planes it does not use
+	if (resizeAudioPool()) {
+		rtClientCtrl.writeOpcode(kPluginBridgeRtClientSetAudioPool);
+		rtClientCtrl.writeULong(static_cast<uint64_t>(audiopool.dataSize));
+		rtClientCtrl.commitWrite();
+	}
+
+	blog(LOG_INFO,
+	     "[" CARLA_MODULE_ID "] shared memory in use: %u KiB"
+	     " (audio pool %u KiB)",
+	     static_cast<uint>((audiopool.dataSize + sizeof(BridgeRtClientData) +
+				sizeof(BridgeNonRtClientData) +
+				sizeof(BridgeNonRtServerData)) /
+			       1024),
+	     static_cast<uint>(audiopool.dataSize / 1024));
+
 	if (activated) {
 		nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientActivate);
 		nonRtClientCtrl.commitWrite();
@@ -449,13 +1379,17 @@ bool carla_bridge::start(const BinaryType btype, const PluginType ptype,
 	// finally assign childprocess
 	childprocess = proc;
 
+	// new process, nothing has been sent to it yet
+	customData.mark_all_dirty();
+
+	ready = true;
+
 	return true;
 }
 
 bool carla_bridge::is_running() const
 {
-	return childprocess != nullptr &&
-	       childprocess->state() == QProcess::Running;
+	return childprocess != nullptr && childprocess->isRunning();
 }
 
 bool carla_bridge::idle()
@@ -463,29 +1397,25 @@ bool carla_bridge::idle()
 	if (childprocess == nullptr)
 		return false;
 
-	switch (childprocess->state()) {
-	case QProcess::Running:
-		if (!pendingPing) {
-			pendingPing = true;
-
-			const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
-
-			nonRtClientCtrl.writeOpcode(
-				kPluginBridgeNonRtClientPing);
-			nonRtClientCtrl.commitWrite();
-		}
-		break;
-	case QProcess::NotRunning:
+	if (!childprocess->isRunning()) {
 		blog(LOG_INFO,
 		     "[" CARLA_MODULE_ID "] bridge closed by itself!");
 		activated = false;
 		timedErr = true;
-		cleanup(false);
-		return false;
-	default:
+		cleanup(false, true);
+		crashed = true;
 		return false;
 	}
 
+	if (!pendingPing) {
+		pendingPing = true;
+
+		const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+
+		nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientPing);
+		nonRtClientCtrl.commitWrite();
+	}
+
 	if (timedOut && activated) {
 		deactivate();
 		return idle();
@@ -496,6 +1426,11 @@ bool carla_bridge::idle()
 	}
 	CARLA_SAFE_EXCEPTION("readMessages");
 
+	// state from `request_save` received, or timeout after 10s
+	if (saveTime != 0 &&
+	    (saved || carla_gettime_ms() - saveTime > 10000))
+		finish_save();
+
 	return true;
 }
 
@@ -518,9 +1453,9 @@ bool carla_bridge::wait(const char *const action, const uint msecs)
 
 void carla_bridge::set_value(uint index, float value)
 {
-	CARLA_SAFE_ASSERT_UINT2_RETURN(index < paramCount, index, paramCount, );
+	CARLA_SAFE_ASSERT_UINT2_RETURN(index < params.count, index, params.count, );
 
-	paramDetails[index].value = value;
+	params.values[index] = value;
 
 	if (is_running()) {
 		const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
@@ -583,6 +1518,11 @@ void carla_bridge::deactivate()
 	CARLA_SAFE_ASSERT_RETURN(activated, );
 
 	activated = false;
+	wait_audio_idle();
+
+	finish_pending_process();
+	reset_delay();
+
 	timedErr = false;
 	timedOut = false;
 
@@ -634,7 +1574,8 @@ void carla_bridge::reload()
 	const uint64_t start_time = carla_gettime_ms();
 
 	while (childprocess != nullptr && !ready) {
-		carla_msleep(5);
+		if (!nonRtServerCtrl.isDataAvailableForReading())
+			carla_msleep(5);
 
 		// timeout after 1s
 		if (carla_gettime_ms() - start_time > 1000)
@@ -642,112 +1583,64 @@ void carla_bridge::reload()
 
 		readMessages();
 	}
+
+	// plugin I/O might have changed, same as in `start()`
+	if (ready) {
+		ready = false;
+		wait_audio_idle();
+
+		if (resizeAudioPool()) {
+			rtClientCtrl.writeOpcode(
+				kPluginBridgeRtClientSetAudioPool);
+			rtClientCtrl.writeULong(
+				static_cast<uint64_t>(audiopool.dataSize));
+			rtClientCtrl.commitWrite();
+		}
+
+		ready = true;
+	}
 }
 
 void carla_bridge::restore_state()
 {
-	const uint32_t maxLocalValueLen = clientBridgeVersion >= 10 ? 4096
-								    : 16384;
-
 	const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
 
-	for (CustomData &cdata : customData) {
-		const uint32_t typeLen =
-			static_cast<uint32_t>(std::strlen(cdata.type));
-		const uint32_t keyLen =
-			static_cast<uint32_t>(std::strlen(cdata.key));
-		const uint32_t valueLen =
-			static_cast<uint32_t>(std::strlen(cdata.value));
+	for (uint32_t i = 0, count = customData.count(); i < count; ++i) {
+		// skip values the bridge already has
+		if (!customData.is_dirty(i))
+			continue;
 
-		nonRtClientCtrl.writeOpcode(
-			kPluginBridgeNonRtClientSetCustomData);
-
-		nonRtClientCtrl.writeUInt(typeLen);
-		nonRtClientCtrl.writeCustomData(cdata.type, typeLen);
-
-		nonRtClientCtrl.writeUInt(keyLen);
-		nonRtClientCtrl.writeCustomData(cdata.key, keyLen);
-
-		nonRtClientCtrl.writeUInt(valueLen);
-
-		if (valueLen > 0) {
-			if (valueLen > maxLocalValueLen) {
-				QString filePath(QDir::tempPath());
-
-				filePath += CARLA_OS_SEP_STR
-					".CarlaCustomData_";
-				filePath += audiopool.getFilenameSuffix();
-
-				QFile file(filePath);
-				if (file.open(QIODevice::WriteOnly) &&
-				    file.write(cdata.value) !=
-					    static_cast<qint64>(valueLen)) {
-					const uint32_t ulength =
-						static_cast<uint32_t>(
-							filePath.length());
-
-					nonRtClientCtrl.writeUInt(ulength);
-					nonRtClientCtrl.writeCustomData(
-						filePath.toUtf8().constData(),
-						ulength);
-				} else {
-					nonRtClientCtrl.writeUInt(0);
-				}
-			} else {
-				nonRtClientCtrl.writeCustomData(cdata.value,
-								valueLen);
-			}
-		}
-
-		nonRtClientCtrl.commitWrite();
-
-		nonRtClientCtrl.waitIfDataIsReachingLimit();
+		const carla_custom_data_store::item cdata(customData.get(i));
+		sendCustomData(cdata.type, cdata.key, cdata.value);
+		customData.set_synced(i);
 	}
 
-	if (info.ptype != PLUGIN_LV2) {
+	if (info.ptype == PLUGIN_LV2) {
 		nonRtClientCtrl.writeOpcode(
 			kPluginBridgeNonRtClientRestoreLV2State);
 		nonRtClientCtrl.commitWrite();
 	}
 
-	if (info.options & PLUGIN_OPTION_USE_CHUNKS) {
-		QString filePath(QDir::tempPath());
-
-		filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
-		filePath += audiopool.getFilenameSuffix();
-
-		QFile file(filePath);
-		if (file.open(QIODevice::WriteOnly) &&
-		    file.write(CarlaString::asBase64(chunk.data(), chunk.size())
-				       .buffer()) != 0) {
-			file.close();
-
-			const uint32_t ulength =
-				static_cast<uint32_t>(filePath.length());
-
-			nonRtClientCtrl.writeOpcode(
-				kPluginBridgeNonRtClientSetChunkDataFile);
-			nonRtClientCtrl.writeUInt(ulength);
-			nonRtClientCtrl.writeCustomData(
-				filePath.toUtf8().constData(), ulength);
-			nonRtClientCtrl.commitWrite();
+	if (info.options & PLUGIN_OPTION_USE_CHUNKS) {
+		if (chunk.isEmpty())
+			return;
 
-			nonRtClientCtrl.waitIfDataIsReachingLimit();
-		}
+		const QByteArray b64chunk(chunk.toBase64());
+		sendChunk(b64chunk.constData(), b64chunk.size());
 	} else {
-		for (uint32_t i = 0; i < paramCount; ++i) {
-			const carla_param_data &param(paramDetails[i]);
+		for (uint32_t i = 0; i < params.count; ++i) {
+			const float value = params.values[i];
 
 			nonRtClientCtrl.writeOpcode(
 				kPluginBridgeNonRtClientSetParameterValue);
 			nonRtClientCtrl.writeUInt(i);
-			nonRtClientCtrl.writeFloat(param.value);
+			nonRtClientCtrl.writeFloat(value);
 			nonRtClientCtrl.commitWrite();
 
 			nonRtClientCtrl.writeOpcode(
 				kPluginBridgeNonRtClientUiParameterChange);
 			nonRtClientCtrl.writeUInt(i);
-			nonRtClientCtrl.writeFloat(param.value);
+			nonRtClientCtrl.writeFloat(value);
 			nonRtClientCtrl.commitWrite();
 
 			nonRtClientCtrl.waitIfDataIsReachingLimit();
@@ -757,29 +1650,115 @@ void carla_bridge::restore_state()
 
 void carla_bridge::process(float *buffers[MAX_AV_PLANES], const uint32_t frames)
 {
-	if (!ready || !activated)
+	process_begin(buffers, frames);
+	process_end(buffers, frames);
+}
+
+void carla_bridge::process_begin(float *buffers[MAX_AV_PLANES],
+				 const uint32_t frames)
+{
+	audioBusy = true;
+
+	if (!ready || !activated) {
+		audioBusy = false;
+		return;
+	}
+
+	// collected in `process_end()`
+	if (!pipelined) {
+		submit_process(buffers, frames);
+		processPending = true;
 		return;
+	}
 
-	rtClientCtrl.data->timeInfo.usecs = carla_gettime_us();
+	// pipelined mode, collect the block submitted on the previous call
+	// the bridge processed it meanwhile, while other filters were running
+	if (processPending) {
+		processPending = false;
 
-	for (uint32_t c = 0; c < MAX_AV_PLANES; ++c)
-		carla_copyFloats(audiopool.data + (c * bufferSize), buffers[c],
-				 frames);
+		const bool ok = wait("process", 1000);
 
-	{
-		rtClientCtrl.writeOpcode(kPluginBridgeRtClientProcess);
-		rtClientCtrl.writeUInt(frames);
-		rtClientCtrl.commitWrite();
+		for (uint32_t c = 0; c < MAX_AV_PLANES; ++c) {
+			float *const delay = delayBuffer.data() +
+					     (c * bufferSize * 2) + delayFill;
+
+			if (ok && c < info.numAudioOuts)
+				carla_copyFloats(
+					delay,
+					audiopool.data +
+						((c + info.numAudioIns) *
+						 bufferSize),
+					pendingFrames);
+			else
+				carla_zeroFloats(delay, pendingFrames);
+		}
+
+		delayFill += pendingFrames;
+	}
+
+	// start processing this block, without waiting for it
+	submit_process(buffers, frames);
+	processPending = true;
+	pendingFrames = frames;
+
+	// output comes from the delay line, always at least `bufferSize` long
+	for (uint32_t c = 0; c < MAX_AV_PLANES; ++c) {
+		float *const delay = delayBuffer.data() + (c * bufferSize * 2);
+
+		carla_copyFloats(buffers[c], delay, frames);
+		std::memmove(delay, delay + frames,
+			     sizeof(float) * (delayFill - frames));
 	}
 
+	delayFill -= frames;
+}
+
+void carla_bridge::process_end(float *buffers[MAX_AV_PLANES],
+			       const uint32_t frames)
+{
+	// pipelined mode is done in `process_begin()`
+	if (pipelined || !processPending) {
+		audioBusy = false;
+		return;
+	}
+
+	processPending = false;
+
 	if (wait("process", 1000)) {
-		for (uint32_t c = 0; c < MAX_AV_PLANES; ++c)
-			carla_copyFloats(
-				buffers[c],
-				audiopool.data +
-					((c + info.numAudioIns) * bufferSize),
-				frames);
+		const float *const outs =
+			audiopool.data + (info.numAudioIns * bufferSize);
+
+		for (uint32_t c = 0; c < MAX_AV_PLANES; ++c) {
+			// planes without a plugin output are silent
+			if (c < info.numAudioOuts)
+				carla_copyFloats(buffers[c],
+						 outs + (c * bufferSize),
+						 frames);
+			else
+				carla_zeroFloats(buffers[c], frames);
+		}
 	}
+
+	audioBusy = false;
+}
+
+void carla_bridge::set_pipelined(const bool pipelined_)
+{
+	// keep the audio thread out while the delay line changes
+	const bool wasActive = activated.exchange(false);
+	wait_audio_idle();
+
+	finish_pending_process();
+
+	pipelined = pipelined_;
+	reset_delay();
+
+	activated = wasActive;
+}
+
+bool carla_bridge::is_pipelined() const noexcept
+{
+	return pipelined;
 }
 
 void carla_bridge::add_custom_data(const char *const type,
@@ -791,85 +1770,27 @@ void carla_bridge::add_custom_data(const char *const type,
 	CARLA_SAFE_ASSERT_RETURN(key != nullptr && key[0] != '\0', );
 	CARLA_SAFE_ASSERT_RETURN(value != nullptr, );
 
-	// Check if we already have this key
-	bool found = false;
-	for (CustomData &cdata : customData) {
-		if (std::strcmp(cdata.key, key) == 0) {
-			bfree(const_cast<char *>(cdata.value));
-			cdata.value = bstrdup(value);
-			found = true;
-			break;
-		}
-	}
-
-	// Otherwise store it
-	if (!found) {
-		CustomData cdata = {};
-		cdata.type = bstrdup(type);
-		cdata.key = bstrdup(key);
-		cdata.value = bstrdup(value);
-		customData.push_back(cdata);
-	}
-
-	if (sendToPlugin) {
-		const uint32_t maxLocalValueLen =
-			clientBridgeVersion >= 10 ? 4096 : 16384;
-
-		const uint32_t typeLen =
-			static_cast<uint32_t>(std::strlen(type));
-		const uint32_t keyLen = static_cast<uint32_t>(std::strlen(key));
-		const uint32_t valueLen =
-			static_cast<uint32_t>(std::strlen(value));
-
-		const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+	const uint32_t index = customData.set(type, key, value);
 
-		if (valueLen > maxLocalValueLen)
-			nonRtClientCtrl.waitIfDataIsReachingLimit();
+	// cached values stay dirty, `restore_state` sends them later
+	if (!sendToPlugin)
+		return;
 
-		nonRtClientCtrl.writeOpcode(
-			kPluginBridgeNonRtClientSetCustomData);
-
-		nonRtClientCtrl.writeUInt(typeLen);
-		nonRtClientCtrl.writeCustomData(type, typeLen);
-
-		nonRtClientCtrl.writeUInt(keyLen);
-		nonRtClientCtrl.writeCustomData(key, keyLen);
-
-		nonRtClientCtrl.writeUInt(valueLen);
-
-		if (valueLen > 0) {
-			if (valueLen > maxLocalValueLen) {
-				QString filePath(QDir::tempPath());
-
-				filePath += CARLA_OS_SEP_STR
-					".CarlaCustomData_";
-				filePath += audiopool.getFilenameSuffix();
-
-				QFile file(filePath);
-				if (file.open(QIODevice::WriteOnly) &&
-				    file.write(value) !=
-					    static_cast<qint64>(valueLen)) {
-					const uint32_t ulength =
-						static_cast<uint32_t>(
-							filePath.length());
-
-					nonRtClientCtrl.writeUInt(ulength);
-					nonRtClientCtrl.writeCustomData(
-						filePath.toUtf8().constData(),
-						ulength);
-				} else {
-					nonRtClientCtrl.writeUInt(0);
-				}
-			} else {
-				nonRtClientCtrl.writeCustomData(value,
-								valueLen);
-			}
-		}
+	const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+	sendCustomData(type, key, value);
+	customData.set_synced(index);
+}
 
-		nonRtClientCtrl.commitWrite();
+void carla_bridge::set_custom_data_from_bridge(const char *const type,
+					       const char *const key,
+					       const char *const value)
+{
+	CARLA_SAFE_ASSERT_RETURN(type != nullptr && type[0] != '\0', );
+	CARLA_SAFE_ASSERT_RETURN(key != nullptr && key[0] != '\0', );
+	CARLA_SAFE_ASSERT_RETURN(value != nullptr, );
 
-		nonRtClientCtrl.waitIfDataIsReachingLimit();
-	}
+	// the bridge already has this value, no need to send it back
+	customData.set_synced(customData.set(type, key, value));
 }
 
 void carla_bridge::custom_data_loaded()
@@ -885,41 +1806,27 @@ void carla_bridge::custom_data_loaded()
 
 void carla_bridge::clear_custom_data()
 {
-	for (CustomData &cdata : customData) {
-		bfree(const_cast<char *>(cdata.type));
-		bfree(const_cast<char *>(cdata.key));
-		bfree(const_cast<char *>(cdata.value));
-	}
 	customData.clear();
 }
 
 void carla_bridge::load_chunk(const char *b64chunk)
 {
 	chunk = QByteArray::fromBase64(b64chunk);
+	chunkDirty = true;
 
-	QString filePath(QDir::tempPath());
-
-	filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
-	filePath += audiopool.getFilenameSuffix();
-
-	QFile file(filePath);
-	if (file.open(QIODevice::WriteOnly) && file.write(b64chunk) != 0) {
-		file.close();
-
-		const uint32_t ulength =
-			static_cast<uint32_t>(filePath.length());
+	const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+	sendChunk(b64chunk, std::strlen(b64chunk));
+}
 
-		const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+void carla_bridge::load_chunk(const QByteArray &data)
+{
+	chunk = data;
+	chunkDirty = true;
 
-		nonRtClientCtrl.writeOpcode(
-			kPluginBridgeNonRtClientSetChunkDataFile);
-		nonRtClientCtrl.writeUInt(ulength);
-		nonRtClientCtrl.writeCustomData(filePath.toUtf8().constData(),
-						ulength);
-		nonRtClientCtrl.commitWrite();
+	const QByteArray b64chunk(chunk.toBase64());
 
-		nonRtClientCtrl.waitIfDataIsReachingLimit();
-	}
+	const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+	sendChunk(b64chunk.constData(), b64chunk.size());
 }
 
 void carla_bridge::save_and_wait()
@@ -927,31 +1834,14 @@ void carla_bridge::save_and_wait()
 	if (!is_running())
 		return;
 
-	saved = false;
-
-	{
-		const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
-
-		// deactivate bridge client-side ping check
-		// some plugins block during save, preventing regular ping timings
-		nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientPingOnOff);
-		nonRtClientCtrl.writeBool(false);
-		nonRtClientCtrl.commitWrite();
-
-		// tell plugin bridge to save and report any pending data
-		nonRtClientCtrl.writeOpcode(
-			kPluginBridgeNonRtClientPrepareForSave);
-		nonRtClientCtrl.commitWrite();
-	}
+	request_save();
 
 	// wait for "saved" reply
-	const uint64_t start_time = carla_gettime_ms();
-
 	while (is_running() && !saved) {
 		carla_msleep(5);
 
 		// timeout after 10s
-		if (carla_gettime_ms() - start_time > 10000)
+		if (carla_gettime_ms() - saveTime > 10000)
 			break;
 
 		readMessages();
@@ -967,14 +1857,43 @@ void carla_bridge::save_and_wait()
 		}
 	}
 
-	if (is_running()) {
-		const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+	finish_save();
+}
 
-		// reactivate ping check
-		nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientPingOnOff);
-		nonRtClientCtrl.writeBool(true);
-		nonRtClientCtrl.commitWrite();
-	}
+void carla_bridge::request_save()
+{
+	if (!is_running())
+		return;
+
+	saved = false;
+	saveTime = carla_gettime_ms();
+
+	const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+
+	// deactivate bridge client-side ping check
+	// some plugins block during save, preventing regular ping timings
+	nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientPingOnOff);
+	nonRtClientCtrl.writeBool(false);
+	nonRtClientCtrl.commitWrite();
+
+	// tell plugin bridge to save and report any pending data
+	nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientPrepareForSave);
+	nonRtClientCtrl.commitWrite();
+}
+
+void carla_bridge::finish_save()
+{
+	saveTime = 0;
+
+	if (!is_running())
+		return;
+
+	const CarlaMutexLocker cml(nonRtClientCtrl.mutex);
+
+	// reactivate ping check
+	nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientPingOnOff);
+	nonRtClientCtrl.writeBool(true);
+	nonRtClientCtrl.commitWrite();
 }
 
 void carla_bridge::set_buffer_size(const uint32_t maxBufferSize)
@@ -982,10 +1901,17 @@ void carla_bridge::set_buffer_size(const uint32_t maxBufferSize)
 	if (bufferSize == maxBufferSize)
 		return;
 
+	// keep the audio thread out while buffers are reallocated
+	const bool wasActive = activated.exchange(false);
+	wait_audio_idle();
+
+	finish_pending_process();
+
 	bufferSize = maxBufferSize;
+	reset_delay();
 
 	if (is_running()) {
-		audiopool.resize(maxBufferSize, MAX_AV_PLANES, MAX_AV_PLANES);
+		resizeAudioPool();
 
 		rtClientCtrl.writeOpcode(kPluginBridgeRtClientSetAudioPool);
 		rtClientCtrl.writeULong(
@@ -996,9 +1922,247 @@ void carla_bridge::set_buffer_size(const uint32_t maxBufferSize)
 		rtClientCtrl.writeUInt(maxBufferSize);
 		rtClientCtrl.commitWrite();
 	}
+
+	activated = wasActive;
+}
+
+// ----------------------------------------------------------------------------
+
+void carla_bridge::submit_process(float *buffers[MAX_AV_PLANES],
+				  const uint32_t frames)
+{
+	rtClientCtrl.data->timeInfo.usecs = carla_gettime_us();
+
+	const uint32_t ins = std::min<uint32_t>(info.numAudioIns, MAX_AV_PLANES);
+
+	for (uint32_t c = 0; c < ins; ++c)
+		carla_copyFloats(audiopool.data + (c * bufferSize), buffers[c],
+				 frames);
+
+	rtClientCtrl.writeOpcode(kPluginBridgeRtClientProcess);
+	rtClientCtrl.writeUInt(frames);
+	rtClientCtrl.commitWrite();
+}
+
+void carla_bridge::wait_audio_idle()
+{
+	// a pending process call waits at most 1s for the bridge
+	while (audioBusy)
+		carla_msleep(1);
+}
+
+void carla_bridge::finish_pending_process()
+{
+	if (!processPending)
+		return;
+
+	processPending = false;
+
+	if (!timedErr && !timedOut)
+		wait("process", 1000);
+}
+
+void carla_bridge::reset_delay()
+{
+	if (!pipelined) {
+		delayBuffer.clear();
+		delayFill = 0;
+		return;
+	}
+
+	// one full buffer of silence, so output never runs dry
+	delayBuffer.assign(MAX_AV_PLANES * bufferSize * 2, 0.f);
+	delayFill = bufferSize;
+}
+
+bool carla_bridge::writeBulkData(const char *const prefix,
+				 const char *const data, const qint64 size,
+				 QString &filePath)
+{
+	filePath = getBulkTransferPath();
+	filePath += CARLA_OS_SEP_STR;
+	filePath += prefix;
+	filePath += audiopool.getFilenameSuffix();
+
+	QFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	return file.write(data, size) == size;
+}
+
+QString carla_bridge::toBridgePath(const QString &hostPath) const
+{
+	if (winePrefix.isEmpty())
+		return hostPath;
+
+	// Wine maps the whole host filesystem as drive Z:
+	QString path(QStringLiteral("Z:") + hostPath);
+	return path.replace('/', '\\');
+}
+
+QString carla_bridge::fromBridgePath(const QString &bridgePath) const
+{
+	if (winePrefix.isEmpty() || bridgePath.length() < 3 ||
+	    bridgePath[1] != ':')
+		return bridgePath;
+
+	// each drive letter is a symlink inside the prefix
+	QString path(winePrefix + "/dosdevices/" + bridgePath[0].toLower() +
+		     ':' + bridgePath.mid(2));
+	path.replace('\\', '/');
+
+	blog(LOG_DEBUG, "[" CARLA_MODULE_ID "] bridge path %s => %s",
+	     bridgePath.toUtf8().constData(), path.toUtf8().constData());
+
+	return path;
+}
+
+// NOTE: must be called with nonRtClientCtrl mutex locked
+void carla_bridge::sendChunk(const char *const b64chunk, const qint64 size)
+{
+	QString filePath;
+
+	if (!writeBulkData(".CarlaChunk_", b64chunk, size, filePath))
+		return;
+
+	const QByteArray filePathUtf8(toBridgePath(filePath).toUtf8());
+	const uint32_t ulength = static_cast<uint32_t>(filePathUtf8.size());
+
+	nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientSetChunkDataFile);
+	nonRtClientCtrl.writeUInt(ulength);
+	nonRtClientCtrl.writeCustomData(filePathUtf8.constData(), ulength);
+	nonRtClientCtrl.commitWrite();
+
+	nonRtClientCtrl.waitIfDataIsReachingLimit();
+}
+
+// NOTE: must be called with nonRtClientCtrl mutex locked
+void carla_bridge::sendCustomData(const char *const type,
+				  const char *const key,
+				  const char *const value)
+{
+	const uint32_t maxLocalValueLen = clientBridgeVersion >= 10 ? 4096
+								    : 16384;
+
+	const uint32_t typeLen = static_cast<uint32_t>(std::strlen(type));
+	const uint32_t keyLen = static_cast<uint32_t>(std::strlen(key));
+	const uint32_t valueLen = static_cast<uint32_t>(std::strlen(value));
+
+	if (valueLen > maxLocalValueLen)
+		nonRtClientCtrl.waitIfDataIsReachingLimit();
+
+	nonRtClientCtrl.writeOpcode(kPluginBridgeNonRtClientSetCustomData);
+
+	nonRtClientCtrl.writeUInt(typeLen);
+	nonRtClientCtrl.writeCustomData(type, typeLen);
+
+	nonRtClientCtrl.writeUInt(keyLen);
+	nonRtClientCtrl.writeCustomData(key, keyLen);
+
+	nonRtClientCtrl.writeUInt(valueLen);
+
+	if (valueLen > 0) {
+		if (valueLen > maxLocalValueLen) {
+			QString filePath;
+
+			if (writeBulkData(".CarlaCustomData_", value, valueLen,
+					  filePath)) {
+				const QByteArray filePathUtf8(
+					toBridgePath(filePath).toUtf8());
+				const uint32_t ulength = static_cast<uint32_t>(
+					filePathUtf8.size());
+
+				nonRtClientCtrl.writeUInt(ulength);
+				nonRtClientCtrl.writeCustomData(
+					filePathUtf8.constData(), ulength);
+			} else {
+				nonRtClientCtrl.writeUInt(0);
+			}
+		} else {
+			nonRtClientCtrl.writeCustomData(value, valueLen);
+		}
+	}
+
+	nonRtClientCtrl.commitWrite();
+
+	nonRtClientCtrl.waitIfDataIsReachingLimit();
 }
 
 // ----------------------------------------------------------------------------
+
+uint32_t carla_bridge::readParamString(const bool dedup)
+{
+	const uint32_t size = nonRtServerCtrl.readUInt();
+
+	if (size == 0)
+		return 0;
+
+	std::vector<char> &strings(params.strings);
+
+	const uint32_t offset = static_cast<uint32_t>(strings.size());
+	strings.resize(offset + size + 1);
+	nonRtServerCtrl.readCustomData(strings.data() + offset, size);
+	strings[offset + size] = '\0';
+
+	if (dedup) {
+		for (const uint32_t other : params.uniqueUnits) {
+			if (std::strcmp(strings.data() + other,
+					strings.data() + offset) == 0) {
+				strings.resize(offset);
+				return other;
+			}
+		}
+
+		// keep lookup short, plugins only have a few distinct units
+		if (params.uniqueUnits.size() < 64)
+			params.uniqueUnits.push_back(offset);
+	}
+
+	return offset;
+}
+
+bool carla_bridge::resizeAudioPool()
+{
+	const std::size_t oldSize = audiopool.dataSize;
+
+	uint32_t audioPorts = info.numAudioIns + info.numAudioOuts;
+	uint32_t cvPorts = info.numCvIns + info.numCvOuts;
+
+	// plugin not known yet, be ready for anything
+	if (audioPorts + cvPorts == 0) {
+		audioPorts = MAX_AV_PLANES * 2;
+		cvPorts = 0;
+	}
+
+	audiopool.resize(bufferSize, audioPorts, cvPorts);
+
+	prefault_memory(audiopool.data, audiopool.dataSize, policy.lockMemory);
+
+	return audiopool.dataSize != oldSize;
+}
+
+void carla_bridge::bindSharedMemory()
+{
+#ifdef CARLA_OS_LINUX
+	if (policy.numaNode < 0 || policy.numaNode >= 64)
+		return;
+
+	const unsigned long mask = 1UL << policy.numaNode;
+
+	// audio data is touched on every process cycle by both sides
+	if (syscall(SYS_mbind, audiopool.data, audiopool.dataSize, MPOL_BIND,
+		    &mask, sizeof(mask) * 8 + 1, MPOL_MF_MOVE) != 0 ||
+	    syscall(SYS_mbind, rtClientCtrl.data, sizeof(BridgeRtClientData),
+		    MPOL_BIND, &mask, sizeof(mask) * 8 + 1,
+		    MPOL_MF_MOVE) != 0)
+		blog(LOG_WARNING,
+		     "[" CARLA_MODULE_ID "] failed to bind shared memory"
+		     " to NUMA node %d",
+		     policy.numaNode);
+#endif
+}
+
 void carla_bridge::readMessages()
 {
 	while (nonRtServerCtrl.isDataAvailableForReading()) {
@@ -1006,7 +2170,12 @@ void carla_bridge::readMessages()
 			nonRtServerCtrl.readOpcode();
 
 		// #ifdef DEBUG
+		// skip frequent and per-parameter messages
 		if (opcode != kPluginBridgeNonRtServerPong &&
+		    opcode != kPluginBridgeNonRtServerParameterData1 &&
+		    opcode != kPluginBridgeNonRtServerParameterData2 &&
+		    opcode != kPluginBridgeNonRtServerParameterRanges &&
+		    opcode != kPluginBridgeNonRtServerParameterValue &&
 		    opcode != kPluginBridgeNonRtServerParameterValue2) {
 			blog(LOG_DEBUG,
 			     "carla_bridge::readMessages() - got opcode: %s",
@@ -1078,20 +2247,13 @@ void carla_bridge::readMessages()
 
 		// uint/ins, uint/outs
 		case kPluginBridgeNonRtServerCvCount:
-			nonRtServerCtrl.readUInt();
-			nonRtServerCtrl.readUInt();
+			info.numCvIns = nonRtServerCtrl.readUInt();
+			info.numCvOuts = nonRtServerCtrl.readUInt();
 			break;
 
 		// uint/count
 		case kPluginBridgeNonRtServerParameterCount: {
-			paramCount = nonRtServerCtrl.readUInt();
-
-			delete[] paramDetails;
-
-			if (paramCount != 0)
-				paramDetails = new carla_param_data[paramCount];
-			else
-				paramDetails = nullptr;
+			params.resize(nonRtServerCtrl.readUInt());
 		} break;
 
 		// uint/count
@@ -1123,41 +2285,55 @@ void carla_bridge::readMessages()
 			const uint32_t hints = nonRtServerCtrl.readUInt();
 			nonRtServerCtrl.readShort();
 
-			CARLA_SAFE_ASSERT_UINT2_BREAK(index < paramCount, index,
-						      paramCount);
+			CARLA_SAFE_ASSERT_UINT2_BREAK(index < params.count, index,
+						      params.count);
 
-			if (type != PARAMETER_INPUT)
-				break;
 			if ((hints & PARAMETER_IS_ENABLED) == 0)
 				break;
+
+			// outputs are kept for display, including their ranges
+			if (type == PARAMETER_OUTPUT) {
+				params.hints[index] = hints;
+				params.outputs[index] = true;
+				break;
+			}
+
+			if (type != PARAMETER_INPUT)
+				break;
 			if (hints &
 			    (PARAMETER_IS_READ_ONLY | PARAMETER_IS_NOT_SAVED))
 				break;
 
-			paramDetails[index].hints = hints;
+			params.hints[index] = hints;
 		} break;
 
 		// uint/index, uint/size, str[] (name), uint/size, str[] (unit)
 		case kPluginBridgeNonRtServerParameterData2: {
 			const uint32_t index = nonRtServerCtrl.readUInt();
 
+			CARLA_SAFE_ASSERT_UINT2(index < params.count, index,
+						params.count);
+
+			// skip strings of parameters we do not use
+			if (index >= params.count ||
+			    (params.hints[index] & PARAMETER_IS_ENABLED) == 0) {
+				for (int i = 0; i < 3; ++i) {
+					if (const uint32_t size =
+						    nonRtServerCtrl.readUInt())
+						nonRtServerCtrl.skipRead(size);
+				}
+				break;
+			}
+
 			// name
-			const BridgeTextReader name(nonRtServerCtrl);
+			params.names[index] = readParamString(false);
 
 			// symbol
-			const BridgeTextReader symbol(nonRtServerCtrl);
+			if (const uint32_t size = nonRtServerCtrl.readUInt())
+				nonRtServerCtrl.skipRead(size);
 
 			// unit
-			const BridgeTextReader unit(nonRtServerCtrl);
-
-			CARLA_SAFE_ASSERT_UINT2_BREAK(index < paramCount, index,
-						      paramCount);
-
-			if (paramDetails[index].hints & PARAMETER_IS_ENABLED) {
-				paramDetails[index].name = name.text;
-				paramDetails[index].symbol = symbol.text;
-				paramDetails[index].unit = unit.text;
-			}
+			params.units[index] = readParamString(true);
 		} break;
 
 		// uint/index, float/def, float/min, float/max, float/step, float/stepSmall, float/stepLarge
@@ -1173,15 +2349,15 @@ void carla_bridge::readMessages()
 			CARLA_SAFE_ASSERT_BREAK(min < max);
 			CARLA_SAFE_ASSERT_BREAK(def >= min);
 			CARLA_SAFE_ASSERT_BREAK(def <= max);
-			CARLA_SAFE_ASSERT_UINT2_BREAK(index < paramCount, index,
-						      paramCount);
-
-			if (paramDetails[index].hints & PARAMETER_IS_ENABLED) {
-				paramDetails[index].def =
-					paramDetails[index].value = def;
-				paramDetails[index].min = min;
-				paramDetails[index].max = max;
-				paramDetails[index].step = step;
+			CARLA_SAFE_ASSERT_UINT2_BREAK(index < params.count, index,
+						      params.count);
+
+			if (params.hints[index] & PARAMETER_IS_ENABLED) {
+				params.defs[index] =
+					params.values[index] = def;
+				params.mins[index] = min;
+				params.maxs[index] = max;
+				params.steps[index] = step;
 			}
 		} break;
 
@@ -1190,19 +2366,18 @@ void carla_bridge::readMessages()
 			const uint32_t index = nonRtServerCtrl.readUInt();
 			const float value = nonRtServerCtrl.readFloat();
 
-			if (index < paramCount) {
+			if (index < params.count) {
 				const float fixedValue = carla_fixedValue(
-					paramDetails[index].min,
-					paramDetails[index].max, value);
+					params.mins[index],
+					params.maxs[index], value);
 
-				if (carla_isNotEqual(paramDetails[index].value,
+				if (carla_isNotEqual(params.values[index],
 						     fixedValue)) {
-					paramDetails[index].value = fixedValue;
+					params.values[index] = fixedValue;
 
 					if (callback != nullptr) {
-						// skip parameters that we do not show
-						if ((paramDetails[index].hints &
-						     PARAMETER_IS_ENABLED) == 0)
+						// skip parameters that are not saved
+						if (!params.is_input(index))
 							break;
 
 						callback->bridge_parameter_changed(
@@ -1217,11 +2392,11 @@ void carla_bridge::readMessages()
 			const uint32_t index = nonRtServerCtrl.readUInt();
 			const float value = nonRtServerCtrl.readFloat();
 
-			if (index < paramCount) {
+			if (index < params.count) {
 				const float fixedValue = carla_fixedValue(
-					paramDetails[index].min,
-					paramDetails[index].max, value);
-				paramDetails[index].value = fixedValue;
+					params.mins[index],
+					params.maxs[index], value);
+				params.values[index] = fixedValue;
 			}
 		} break;
 
@@ -1236,8 +2411,8 @@ void carla_bridge::readMessages()
 			const uint32_t index = nonRtServerCtrl.readUInt();
 			const float value = nonRtServerCtrl.readFloat();
 
-			if (index < paramCount)
-				paramDetails[index].def = value;
+			if (index < params.count)
+				params.defs[index] = value;
 		} break;
 
 		// int/index
@@ -1288,25 +2463,26 @@ void carla_bridge::readMessages()
 				const BridgeTextReader bigValueFilePath(
 					nonRtServerCtrl, valueSize);
 
-				QString realBigValueFilePath(QString::fromUtf8(
-					bigValueFilePath.text));
+				const QString realBigValueFilePath(
+					fromBridgePath(QString::fromUtf8(
+						bigValueFilePath.text)));
 
 				QFile bigValueFile(realBigValueFilePath);
 				CARLA_SAFE_ASSERT_BREAK(bigValueFile.exists());
 
 				if (bigValueFile.open(QIODevice::ReadOnly)) {
-					add_custom_data(type.text, key.text,
-							bigValueFile.readAll()
-								.constData(),
-							false);
+					set_custom_data_from_bridge(
+						type.text, key.text,
+						bigValueFile.readAll()
+							.constData());
 					bigValueFile.remove();
 				}
 			} else {
 				const BridgeTextReader value(nonRtServerCtrl,
 							     valueSize);
 
-				add_custom_data(type.text, key.text, value.text,
-						false);
+				set_custom_data_from_bridge(type.text, key.text,
+							    value.text);
 			}
 
 		} break;
@@ -1316,16 +2492,23 @@ void carla_bridge::readMessages()
 			// chunkFilePath
 			const BridgeTextReader chunkFilePath(nonRtServerCtrl);
 
-			QString realChunkFilePath(
-				QString::fromUtf8(chunkFilePath.text));
+			const QString realChunkFilePath(fromBridgePath(
+				QString::fromUtf8(chunkFilePath.text)));
 
 			QFile chunkFile(realChunkFilePath);
 			CARLA_SAFE_ASSERT_BREAK(chunkFile.exists());
 
 			if (chunkFile.open(QIODevice::ReadOnly)) {
-				chunk = QByteArray::fromBase64(
-					chunkFile.readAll());
+				const QByteArray newChunk(
+					QByteArray::fromBase64(
+						chunkFile.readAll()));
 				chunkFile.remove();
+
+				// plugins report the same state on every save
+				if (chunk != newChunk) {
+					chunk = newChunk;
+					chunkDirty = true;
+				}
 			}
 		} break;
 
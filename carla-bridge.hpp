@@ -12,9 +12,19 @@
 #include <QtCore/QByteArray>
 #include <QtCore/QProcess>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 
+#include <atomic>
 #include <vector>
 
+#ifdef CARLA_OS_LINUX
+#include <sched.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
 // generates warning if defined as anything else
 #define CARLA_API
 
@@ -24,32 +34,159 @@
 CARLA_BACKEND_USE_NAMESPACE
 
 // ----------------------------------------------------------------------------
-// custom class for allowing QProcess usage outside the main thread
+// scheduling and memory placement for bridge processes
+// CPUs work on Linux and Windows, NUMA binding only on Linux
+
+struct carla_bridge_policy {
+	// CPUs the bridge may run on, in taskset list format (e.g. "2,3,6-7")
+	// empty means any CPU
+	CarlaString cpus;
+
+	// process nice level, 0 keeps the default
+	int nice = 0;
+
+	// allow the bridge to request realtime priority for its audio thread
+	bool realtime = false;
+
+	// NUMA node for process and shared memory, -1 means no binding
+	int numaNode = -1;
+
+	// lock shared memory in RAM, so it never gets paged out
+	bool lockMemory = false;
+};
+
+// ----------------------------------------------------------------------------
+// bridge process launcher, all methods can be used from any thread
+// the process inherits stdin/stdout/stderr from OBS
 
+#ifdef _WIN32
+// uses QProcess, which needs the main thread for most of its work
 class BridgeProcess : public QProcess {
 	Q_OBJECT
 
 public:
-	BridgeProcess(const char *shmIds);
+	BridgeProcess(const char *shmIds, const carla_bridge_policy &policy);
 
-public Q_SLOTS:
-	void start();
+	// start process and wait until it is running
+	bool launch(const QString &program, const QStringList &arguments);
+
+	bool isRunning() const;
+
+	// only valid once the process is no longer running
+	bool hasCrashed() const;
+
+	// ask process to close, killing it if needed
+	// NOTE: process instance cannot be used after this!
 	void stop();
+
+private Q_SLOTS:
+	void startOnMainThread();
+	void stopOnMainThread();
+
+private:
+	enum StartStatus { START_PENDING, START_OK, START_FAILED };
+	std::atomic<int> startStatus{START_PENDING};
+
+	// parsed policy, applied once the process has started
+	uintptr_t cpuMask = 0;
+	int nice = 0;
+
+	void applyPolicy();
 };
+#else
+// native launcher, independent of the Qt event loop
+// the process exit is noticed through a pidfd where available
+class BridgeProcess {
+public:
+	BridgeProcess(const char *shmIds, const carla_bridge_policy &policy);
+	~BridgeProcess();
+
+	// start process and wait until it is running
+	bool launch(const QString &program, const QStringList &arguments);
+
+	bool isRunning();
+
+	// only valid once the process is no longer running
+	bool hasCrashed() const noexcept { return crashed; }
+
+	// ask process to close, killing it if needed
+	// NOTE: process instance cannot be used after this!
+	void stop();
+
+	// add or replace an environment variable, must be called before launch
+	void setEnvironmentValue(const char *name, const QByteArray &value);
+
+private:
+	pid_t pid = -1;
+	int pidfd = -1;
+	bool crashed = false;
+
+	// full child environment, as "NAME=value" strings
+	std::vector<QByteArray> environment;
+
+	int nice = 0;
+
+#ifdef CARLA_OS_LINUX
+	// parsed policy, applied in the child process between fork and exec
+	// where only async-signal-safe calls can be used
+	bool hasCpuMask = false;
+	cpu_set_t cpuMask;
+	unsigned long numaMask = 0;
+	bool realtime = false;
+
+	void applyPolicy();
+#endif
+
+	// collect exit status if the process has finished, optionally waiting
+	// returns true if the process is gone
+	bool reap(bool block);
+	bool waitForExit(uint msecs);
+};
+#endif
 
 // ----------------------------------------------------------------------------
-// relevant information for an exposed plugin parameter
+// cached plugin parameters, kept as one contiguous array per field
+// names and units live in a single string pool and are referenced by offset
+
+struct carla_param_cache {
+	uint32_t count = 0;
+	std::vector<uint32_t> hints;
+	std::vector<float> values;
+	std::vector<float> defs;
+	std::vector<float> mins;
+	std::vector<float> maxs;
+	std::vector<float> steps;
+	std::vector<uint32_t> names;
+	std::vector<uint32_t> units;
+
+	// plugin outputs, shown read-only and never written to settings
+	std::vector<bool> outputs;
+
+	// null-terminated strings, offset 0 is always an empty string
+	std::vector<char> strings = std::vector<char>(1, '\0');
+
+	// offsets of distinct units seen so far, units are often repeated
+	std::vector<uint32_t> uniqueUnits;
+
+	// reset all parameter data for a new parameter count
+	void resize(uint32_t newCount);
+
+	// enabled parameter the user can change and that is saved
+	bool is_input(uint32_t index) const noexcept
+	{
+		return (hints[index] & PARAMETER_IS_ENABLED) != 0 &&
+		       !outputs[index];
+	}
 
-struct carla_param_data {
-	uint32_t hints = 0;
-	float value = 0.f;
-	float def = 0.f;
-	float min = 0.f;
-	float max = 1.f;
-	float step = 0.01f;
-	CarlaString name;
-	CarlaString symbol;
-	CarlaString unit;
+	const char *get_name(uint32_t index) const noexcept
+	{
+		return strings.data() + names[index];
+	}
+
+	const char *get_unit(uint32_t index) const noexcept
+	{
+		return strings.data() + units[index];
+	}
 };
 
 // ----------------------------------------------------------------------------
@@ -62,6 +199,8 @@ struct carla_bridge_info {
 	uint32_t options = PLUGIN_OPTIONS_NULL;
 	uint32_t numAudioIns = 0;
 	uint32_t numAudioOuts = 0;
+	uint32_t numCvIns = 0;
+	uint32_t numCvOuts = 0;
 	int64_t uniqueId = 0;
 	CarlaString filename;
 	CarlaString label;
@@ -73,12 +212,73 @@ struct carla_bridge_info {
 		hints = 0;
 		options = PLUGIN_OPTIONS_NULL;
 		numAudioIns = numAudioOuts = 0;
+		numCvIns = numCvOuts = 0;
 		uniqueId = 0;
 		label.clear();
 		filename.clear();
 	}
 };
 
+// ----------------------------------------------------------------------------
+// custom data storage, indexed by type and key
+// all strings live in a single arena, entries and hash table only keep offsets
+
+struct carla_custom_data_store {
+	struct item {
+		const char *type;
+		const char *key;
+		const char *value;
+		uint32_t valueLen;
+	};
+
+	uint32_t count() const noexcept
+	{
+		return static_cast<uint32_t>(entries.size());
+	}
+
+	bool empty() const noexcept { return entries.empty(); }
+
+	// get entry at index
+	// returned pointers are only valid until the next store change
+	item get(uint32_t index) const noexcept;
+
+	// add or replace a value, returning its entry index
+	// entry is marked dirty if the value is new or changed
+	// NOTE: strings must not point inside the store itself
+	uint32_t set(const char *type, const char *key, const char *value);
+
+	// dirty entries have values not yet known by the bridge
+	bool is_dirty(uint32_t index) const noexcept;
+	void set_synced(uint32_t index) noexcept;
+
+	// needed when a new bridge process is started
+	void mark_all_dirty() noexcept;
+
+	void clear() noexcept;
+
+private:
+	struct entry {
+		uint64_t hash;
+		uint32_t type;
+		uint32_t key;
+		uint32_t value;
+		uint32_t valueLen;
+		uint32_t valueCapacity;
+		bool dirty;
+	};
+
+	std::vector<char> arena;
+	std::vector<entry> entries;
+	std::vector<uint32_t> buckets;
+	size_t garbage = 0;
+
+	uint32_t find(uint64_t hash, const char *type,
+		      const char *key) const noexcept;
+	uint32_t store_string(const char *str, uint32_t len);
+	void insert_bucket(uint32_t index);
+	void compact();
+};
+
 // ----------------------------------------------------------------------------
 // bridge callbacks, triggered during carla_bridge::idle()
 
@@ -94,25 +294,29 @@ struct carla_bridge {
 	carla_bridge_callback *callback = nullptr;
 
 	// cached parameter info
-	uint32_t paramCount = 0;
-	carla_param_data *paramDetails = nullptr;
+	carla_param_cache params;
+
+	// scheduling policy, used for the next bridge process start
+	carla_bridge_policy policy;
 
 	// cached plugin info
 	carla_bridge_info info;
 	QByteArray chunk;
-	std::vector<CustomData> customData;
+	carla_custom_data_store customData;
 
-	~carla_bridge()
-	{
-		delete[] paramDetails;
-		clear_custom_data();
-	}
+	// set whenever `chunk` contents change
+	// users caching an encoded form of the chunk can clear it
+	bool chunkDirty = true;
+
+	~carla_bridge() { clear_custom_data(); }
 
 	// initialize bridge shared memory details
+	// cheap if shared memory was kept from a previous `cleanup()`
 	bool init(uint32_t maxBufferSize, double sampleRate);
 
 	// stop bridge process and cleanup shared memory
-	void cleanup(bool clearPluginData = true);
+	// shared memory can be kept for a faster restart through `init()`
+	void cleanup(bool clearPluginData = true, bool keepChannels = false);
 
 	// start plugin bridge
 	bool start(BinaryType btype, PluginType ptype, const char *label,
@@ -122,6 +326,10 @@ struct carla_bridge {
 	// return status might be wrong when called outside the main thread
 	bool is_running() const;
 
+	// check if plugin bridge process stopped by itself (crashed)
+	// status is reset on the next `cleanup()`
+	bool has_crashed() const noexcept { return crashed; }
+
 	// to be called at regular intervals, from the main thread
 	// returns false if bridge process is not running
 	bool idle();
@@ -152,7 +360,21 @@ struct carla_bridge {
 	// frames must be <= `maxBufferSize` as passed during `init`
 	void process(float *buffers[MAX_AV_PLANES], uint32_t frames);
 
+	// same as `process()` split in two, so that several bridges can work
+	// on the same block at once: `process_begin()` on all of them first,
+	// then `process_end()` with the same arguments
+	void process_begin(float *buffers[MAX_AV_PLANES], uint32_t frames);
+	void process_end(float *buffers[MAX_AV_PLANES], uint32_t frames);
+
+	// pipelined processing returns the output of the previous call and
+	// lets the bridge work on the current block in the background,
+	// adding `maxBufferSize` frames of latency
+	// audio processing is paused during the change
+	void set_pipelined(bool pipelined);
+	bool is_pipelined() const noexcept;
+
 	// add or replace custom data (non-parameter plugin values)
+	// if not sent to the plugin now, it is sent by `restore_state`
 	void add_custom_data(const char *type, const char *key,
 			     const char *value, bool sendToPlugin = true);
 
@@ -167,24 +389,38 @@ struct carla_bridge {
 	// NOTE: do not save parameter values for plugins using "chunks"
 	void load_chunk(const char *b64chunk);
 
+	// load plugin state as raw binary chunk
+	void load_chunk(const QByteArray &data);
+
 	// request plugin bridge to save and report back its internal state
 	// must be called just before saving plugin state
 	void save_and_wait();
 
+	// same as `save_and_wait`, without waiting for the reply
+	// the state is received during `idle()`, until `is_saving()` is false
+	void request_save();
+
+	bool is_saving() const noexcept { return saveTime != 0; }
+
 	// change the maximum expected buffer size
 	// plugin is temporarily deactivated during the change
 	void set_buffer_size(uint32_t maxBufferSize);
 
 private:
-	bool activated = false;
+	std::atomic<bool> activated{false};
+	bool channelsReady = false;
+	bool crashed = false;
 	bool pendingPing = false;
-	bool ready = false;
+	std::atomic<bool> ready{false};
 	bool saved = false;
 	bool timedErr = false;
 	bool timedOut = false;
 	uint32_t bufferSize = 0;
 	uint32_t clientBridgeVersion = 0;
 
+	// time of the pending save request, 0 if none
+	uint64_t saveTime = 0;
+
 	BridgeAudioPool audiopool;                // fShmAudioPool
 	BridgeRtClientControl rtClientCtrl;       // fShmRtClientControl
 	BridgeNonRtClientControl nonRtClientCtrl; // fShmNonRtClientControl
@@ -192,7 +428,71 @@ private:
 
 	BridgeProcess *childprocess = nullptr;
 
+	// pipelined processing state, see `set_pipelined()`
+	// `processPending` is also used between `process_begin()` and
+	// `process_end()` when not pipelined
+	bool pipelined = false;
+	bool processPending = false;
+	uint32_t pendingFrames = 0;
+	uint32_t delayFill = 0;
+	std::vector<float> delayBuffer;
+
+	// set by the audio thread from `process_begin()` until `process_end()`
+	// returns, only if `ready` and `activated` were set on entry
+	std::atomic<bool> audioBusy{false};
+
+	// wait for the audio thread to leave, after clearing `ready` or
+	// `activated` so that it does not enter again
+	void wait_audio_idle();
+
+	// reactivate ping check once the state is received or not coming
+	void finish_save();
+
+	void submit_process(float *buffers[MAX_AV_PLANES], uint32_t frames);
+	void finish_pending_process();
+	void reset_delay();
+
 	void readMessages();
+
+	// store custom data reported by the bridge, already known by it
+	void set_custom_data_from_bridge(const char *type, const char *key,
+					 const char *value);
+
+	// bind shared memory to the NUMA node from `policy`, if any
+	void bindSharedMemory();
+
+	// size audio pool for the plugin audio and CV ports, all planes if
+	// not known yet, and fault in its pages; returns true if size changed
+	bool resizeAudioPool();
+
+	// read bridge text directly into the parameter string pool
+	uint32_t readParamString(bool dedup);
+
+	// write big data into a memory-backed file for the bridge to read
+	bool writeBulkData(const char *prefix, const char *data, qint64 size,
+			   QString &filePath);
+
+	// Wine prefix used by the current bridge, empty if not running on Wine
+	QString winePrefix;
+
+	// bridges running on Wine use Windows paths, convert between both
+	QString toBridgePath(const QString &hostPath) const;
+	QString fromBridgePath(const QString &bridgePath) const;
+
+	// send state data to the bridge, nonRtClientCtrl mutex must be locked
+	void sendChunk(const char *b64chunk, qint64 size);
+	void sendCustomData(const char *type, const char *key,
+			    const char *value);
 };
 
 // ----------------------------------------------------------------------------
+// module-wide helpers
+
+// start long-lived helper processes in the background, like a persistent
+// wineserver for Windows plugin bridges
+void carla_bridge_module_load();
+
+// stop everything started by `carla_bridge_module_load()` and later bridges
+void carla_bridge_module_unload();
+
+// ----------------------------------------------------------------------------
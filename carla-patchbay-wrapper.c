@@ -8,6 +8,7 @@
 #include "common.h"
 #include "qtutils.h"
 
+#include <util/darray.h>
 #include <util/platform.h>
 
 // IDE helpers, must match cmake config
@@ -36,17 +37,11 @@ static void carla_main_thread_param_change(void *data)
 	struct carla_main_thread_param_change *priv = data;
 	priv->descriptor->ui_set_parameter_value(priv->handle, priv->index,
 						 priv->value);
-	bfree(data);
 }
 
 // ----------------------------------------------------------------------------
 // private data methods
 
-struct carla_param_data {
-	uint32_t hints;
-	float min, max;
-};
-
 struct carla_priv {
 	obs_source_t *source;
 	uint32_t bufferSize;
@@ -56,9 +51,20 @@ struct carla_priv {
 	NativeHostDescriptor host;
 	NativeTimeInfo timeInfo;
 
-	// cached parameter info
+	// cached parameter info, one array per field
 	uint32_t paramCount;
-	struct carla_param_data *paramDetails;
+	uint32_t *paramHints;
+	float *paramMins;
+	float *paramMaxs;
+
+	// parameters changed from the plugin UI during the current idle pass
+	// only the last value per parameter is kept, applied once per idle
+	float *paramValues;
+	bool *paramChanged;
+	DARRAY(uint32_t) changedParams;
+
+	// currently visible page of parameters
+	uint32_t paramPage;
 
 	// update properties when timeout is reached, 0 means do nothing
 	uint64_t update_request;
@@ -111,27 +117,50 @@ static void host_ui_parameter_changed(NativeHostHandle handle, uint32_t index,
 		return;
 
 	// skip parameters that we do not show
-	const uint32_t hints = priv->paramDetails[index].hints;
+	const uint32_t hints = priv->paramHints[index];
 	if ((hints & NATIVE_PARAMETER_IS_ENABLED) == 0)
 		return;
 	if (hints & NATIVE_PARAMETER_IS_OUTPUT)
 		return;
 
+	priv->paramValues[index] = value;
+
+	if (priv->paramChanged[index])
+		return;
+
+	priv->paramChanged[index] = true;
+	da_push_back(priv->changedParams, &index);
+}
+
+static void carla_priv_apply_param_changes(struct carla_priv *priv)
+{
+	if (priv->changedParams.num == 0)
+		return;
+
 	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
-	param_index_to_name(index, pname);
 
 	obs_source_t *source = priv->source;
 	obs_data_t *settings = obs_source_get_settings(source);
 
-	/**/ if (hints & NATIVE_PARAMETER_IS_BOOLEAN)
-		obs_data_set_bool(settings, pname, value > 0.5f ? 1.f : 0.f);
-	else if (hints & NATIVE_PARAMETER_IS_INTEGER)
-		obs_data_set_int(settings, pname, (int)value);
-	else
-		obs_data_set_double(settings, pname, value);
+	for (size_t i = 0; i < priv->changedParams.num; ++i) {
+		const uint32_t index = priv->changedParams.array[i];
+		const uint32_t hints = priv->paramHints[index];
+		const float value = priv->paramValues[index];
+
+		priv->paramChanged[index] = false;
+		param_index_to_name(index, pname);
+
+		/**/ if (hints & NATIVE_PARAMETER_IS_BOOLEAN)
+			obs_data_set_bool(settings, pname, value > 0.5f);
+		else if (hints & NATIVE_PARAMETER_IS_INTEGER)
+			obs_data_set_int(settings, pname, (int)value);
+		else
+			obs_data_set_double(settings, pname, value);
+	}
 
 	obs_data_release(settings);
 
+	da_resize(priv->changedParams, 0);
 	postpone_update_request(&priv->update_request);
 }
 
@@ -212,6 +241,10 @@ static intptr_t host_dispatcher(NativeHostHandle handle,
 // ----------------------------------------------------------------------------
 // carla + obs integration methods
 
+void carla_priv_module_load(void) {}
+
+void carla_priv_module_unload(void) {}
+
 struct carla_priv *carla_priv_create(obs_source_t *source,
 				     enum buffer_size_mode bufsize,
 				     uint32_t srate)
@@ -285,7 +318,12 @@ void carla_priv_destroy(struct carla_priv *priv)
 		carla_priv_deactivate(priv);
 
 	priv->descriptor->cleanup(priv->handle);
-	bfree(priv->paramDetails);
+	bfree(priv->paramHints);
+	bfree(priv->paramMins);
+	bfree(priv->paramMaxs);
+	bfree(priv->paramValues);
+	bfree(priv->paramChanged);
+	da_free(priv->changedParams);
 	bfree(priv);
 }
 
@@ -316,6 +354,7 @@ void carla_priv_process_audio(struct carla_priv *priv,
 void carla_priv_idle(struct carla_priv *priv)
 {
 	priv->descriptor->ui_idle(priv->handle);
+	carla_priv_apply_param_changes(priv);
 	handle_update_request(priv->source, &priv->update_request);
 }
 
@@ -359,6 +398,12 @@ void carla_priv_set_buffer_size(struct carla_priv *priv,
 		carla_priv_activate(priv);
 }
 
+void carla_priv_show(struct carla_priv *priv)
+{
+	// plugins are loaded together with their state, nothing to start
+	UNUSED_PARAMETER(priv);
+}
+
 // ----------------------------------------------------------------------------
 
 static bool carla_priv_param_changed(void *data, obs_properties_t *props,
@@ -382,8 +427,8 @@ static bool carla_priv_param_changed(void *data, obs_properties_t *props,
 	if (pindex < 0 || pindex >= (int)priv->paramCount)
 		return false;
 
-	const float min = priv->paramDetails[pindex].min;
-	const float max = priv->paramDetails[pindex].max;
+	const float min = priv->paramMins[pindex];
+	const float max = priv->paramMaxs[pindex];
 
 	float value;
 	switch (obs_property_get_type(property)) {
@@ -416,11 +461,8 @@ static bool carla_priv_param_changed(void *data, obs_properties_t *props,
 		.handle = priv->handle,
 		.index = pindex,
 		.value = value};
-	struct carla_main_thread_param_change *mchangeptr =
-		bmalloc(sizeof(mchange));
-	*mchangeptr = mchange;
-	carla_qt_callback_on_main_thread(carla_main_thread_param_change,
-					 mchangeptr);
+	carla_qt_callback_on_main_thread_copy(carla_main_thread_param_change,
+					      &mchange, sizeof(mchange));
 
 	return false;
 }
@@ -453,56 +495,50 @@ static bool carla_priv_show_gui_callback(obs_properties_t *props,
 	return false;
 }
 
-void carla_priv_readd_properties(struct carla_priv *priv,
-				 obs_properties_t *props, bool reset)
+static void carla_priv_add_param_props(struct carla_priv *priv,
+				       obs_properties_t *props,
+				       obs_data_t *settings)
 {
-	obs_data_t *settings = obs_source_get_settings(priv->source);
-
-	if (priv->descriptor->hints & NATIVE_PLUGIN_HAS_UI) {
-		obs_properties_add_button2(props, PROP_SHOW_GUI,
-					   obs_module_text("Show custom GUI"),
-					   carla_priv_show_gui_callback, priv);
-	}
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
 
-	uint32_t params = priv->descriptor->get_parameter_count(priv->handle);
-	if (params > MAX_PARAMS)
-		params = MAX_PARAMS;
+	const uint32_t first = priv->paramPage * PARAMS_PER_PAGE;
+	uint32_t last = first + PARAMS_PER_PAGE;
+	if (last > priv->paramCount)
+		last = priv->paramCount;
 
-	bfree(priv->paramDetails);
-	priv->paramCount = params;
-	priv->paramDetails = bzalloc(sizeof(struct carla_param_data) * params);
+	for (uint32_t i = first; i < last; ++i) {
+		const uint32_t hints = priv->paramHints[i];
 
-	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+		if ((hints & NATIVE_PARAMETER_IS_ENABLED) == 0)
+			continue;
 
-	for (uint32_t i = 0; i < params; ++i) {
 		const NativeParameter *const info =
 			priv->descriptor->get_parameter_info(priv->handle, i);
 
-		if ((info->hints & NATIVE_PARAMETER_IS_ENABLED) == 0)
+		if (info == NULL)
 			continue;
-		if (info->hints & NATIVE_PARAMETER_IS_OUTPUT)
+
+		if (hints & NATIVE_PARAMETER_IS_OUTPUT) {
+			add_output_param_prop(
+				props, i, info->name,
+				priv->descriptor->get_parameter_value(
+					priv->handle, i),
+				info->unit);
 			continue;
+		}
 
 		param_index_to_name(i, pname);
-		priv->paramDetails[i].hints = info->hints;
-		priv->paramDetails[i].min = info->ranges.min;
-		priv->paramDetails[i].max = info->ranges.max;
 
 		obs_property_t *prop;
 
-		if (info->hints & NATIVE_PARAMETER_IS_BOOLEAN) {
+		if (hints & NATIVE_PARAMETER_IS_BOOLEAN) {
 			prop = obs_properties_add_bool(props, pname,
 						       info->name);
 
 			obs_data_set_default_bool(settings, pname,
 						  info->ranges.def ==
 							  info->ranges.max);
-
-			if (reset)
-				obs_data_set_bool(settings, pname,
-						  info->ranges.def ==
-							  info->ranges.max);
-		} else if (info->hints & NATIVE_PARAMETER_IS_INTEGER) {
+		} else if (hints & NATIVE_PARAMETER_IS_INTEGER) {
 			prop = obs_properties_add_int_slider(
 				props, pname, info->name, (int)info->ranges.min,
 				(int)info->ranges.max, (int)info->ranges.step);
@@ -512,10 +548,6 @@ void carla_priv_readd_properties(struct carla_priv *priv,
 
 			if (info->unit && *info->unit)
 				obs_property_int_set_suffix(prop, info->unit);
-
-			if (reset)
-				obs_data_set_int(settings, pname,
-						 (int)info->ranges.def);
 		} else {
 			prop = obs_properties_add_float_slider(
 				props, pname, info->name, info->ranges.min,
@@ -526,17 +558,140 @@ void carla_priv_readd_properties(struct carla_priv *priv,
 
 			if (info->unit && *info->unit)
 				obs_property_float_set_suffix(prop, info->unit);
-
-			if (reset)
-				obs_data_set_double(settings, pname,
-						    info->ranges.def);
 		}
 
 		obs_property_set_modified_callback2(
 			prop, carla_priv_param_changed, priv);
 	}
+}
+
+static bool carla_priv_param_page_changed(void *data, obs_properties_t *props,
+					  obs_property_t *property,
+					  obs_data_t *settings)
+{
+	UNUSED_PARAMETER(property);
+
+	struct carla_priv *priv = data;
+
+	const uint32_t page =
+		(uint32_t)obs_data_get_int(settings, PROP_PARAM_PAGE);
+
+	if (page == priv->paramPage ||
+	    page >= get_param_page_count(priv->paramCount))
+		return false;
+
+	// only the parameters of the selected page are created
+	remove_param_props(props);
+	priv->paramPage = page;
+	carla_priv_add_param_props(priv, props, settings);
+
+	return true;
+}
+
+void carla_priv_readd_properties(struct carla_priv *priv,
+				 obs_properties_t *props, bool reset)
+{
+	obs_data_t *settings = obs_source_get_settings(priv->source);
+
+	if (priv->descriptor->hints & NATIVE_PLUGIN_HAS_UI) {
+		obs_properties_add_button2(props, PROP_SHOW_GUI,
+					   obs_module_text("Show custom GUI"),
+					   carla_priv_show_gui_callback, priv);
+	}
+
+	const uint32_t params =
+		priv->descriptor->get_parameter_count(priv->handle);
+
+	if (params != priv->paramCount) {
+		bfree(priv->paramHints);
+		bfree(priv->paramMins);
+		bfree(priv->paramMaxs);
+		bfree(priv->paramValues);
+		bfree(priv->paramChanged);
+		da_resize(priv->changedParams, 0);
+		priv->paramCount = params;
+		priv->paramHints = bzalloc(sizeof(uint32_t) * params);
+		priv->paramMins = bzalloc(sizeof(float) * params);
+		priv->paramMaxs = bzalloc(sizeof(float) * params);
+		priv->paramValues = bzalloc(sizeof(float) * params);
+		priv->paramChanged = bzalloc(sizeof(bool) * params);
+	}
+
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+
+	// cache details of all parameters, even those not currently visible
+	for (uint32_t i = 0; i < params; ++i) {
+		const NativeParameter *const info =
+			priv->descriptor->get_parameter_info(priv->handle, i);
+
+		if (info == NULL) {
+			priv->paramHints[i] = 0;
+			continue;
+		}
+
+		priv->paramHints[i] = info->hints;
+		priv->paramMins[i] = info->ranges.min;
+		priv->paramMaxs[i] = info->ranges.max;
+
+		if (!reset)
+			continue;
+		if ((info->hints & NATIVE_PARAMETER_IS_ENABLED) == 0)
+			continue;
+		if (info->hints & NATIVE_PARAMETER_IS_OUTPUT)
+			continue;
+
+		param_index_to_name(i, pname);
+
+		if (info->hints & NATIVE_PARAMETER_IS_BOOLEAN)
+			obs_data_set_bool(settings, pname,
+					  info->ranges.def == info->ranges.max);
+		else if (info->hints & NATIVE_PARAMETER_IS_INTEGER)
+			obs_data_set_int(settings, pname,
+					 (int)info->ranges.def);
+		else
+			obs_data_set_double(settings, pname,
+					    info->ranges.def);
+	}
+
+	if (reset) {
+		priv->paramPage = 0;
+		obs_data_set_int(settings, PROP_PARAM_PAGE, 0);
+	} else {
+		priv->paramPage =
+			(uint32_t)obs_data_get_int(settings, PROP_PARAM_PAGE);
+		if (priv->paramPage >= get_param_page_count(params))
+			priv->paramPage = 0;
+	}
+
+	add_param_page_list(props, params, carla_priv_param_page_changed,
+			    priv);
+
+	carla_priv_add_param_props(priv, props, settings);
 
 	obs_data_release(settings);
 }
 
+uint32_t carla_priv_get_output_params(struct carla_priv *priv,
+				      uint32_t *indices, float *values,
+				      uint32_t maxCount)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < priv->paramCount && count < maxCount; ++i) {
+		const uint32_t hints = priv->paramHints[i];
+
+		if ((hints & NATIVE_PARAMETER_IS_ENABLED) == 0)
+			continue;
+		if ((hints & NATIVE_PARAMETER_IS_OUTPUT) == 0)
+			continue;
+
+		indices[count] = i;
+		values[count] =
+			priv->descriptor->get_parameter_value(priv->handle, i);
+		++count;
+	}
+
+	return count;
+}
+
 // ----------------------------------------------------------------------------
@@ -43,6 +43,10 @@ extern "C" {
 
 struct carla_priv;
 
+// module-wide setup, called from obs_module_load and obs_module_unload
+void carla_priv_module_load(void);
+void carla_priv_module_unload(void);
+
 struct carla_priv *carla_priv_create(obs_source_t *source,
 				     enum buffer_size_mode bufsize,
 				     uint32_t srate);
@@ -50,20 +54,63 @@ void carla_priv_destroy(struct carla_priv *carla);
 
 void carla_priv_activate(struct carla_priv *carla);
 void carla_priv_deactivate(struct carla_priv *carla);
+
+// source is shown somewhere, e.g. in the preview
+void carla_priv_show(struct carla_priv *carla);
+
 void carla_priv_process_audio(struct carla_priv *carla,
 			      float *buffers[MAX_AV_PLANES], uint32_t frames);
 
 void carla_priv_idle(struct carla_priv *carla);
 
 void carla_priv_save(struct carla_priv *carla, obs_data_t *settings);
+// in the bridge module with `PROP_LAZY_START` set, the plugin is only
+// started on first use
 void carla_priv_load(struct carla_priv *carla, obs_data_t *settings);
 
 void carla_priv_set_buffer_size(struct carla_priv *carla,
 				enum buffer_size_mode bufsize);
 
+#ifdef BUILDING_CARLA_OBS
+// bridge module only, its plugins run in separate processes
+
+// pipelined processing trades one buffer of latency for not blocking on
+// the plugin during the audio callback
+void carla_priv_set_pipelined(struct carla_priv *carla, bool pipelined);
+
+// CPU list, nice level, realtime permission, NUMA node and memory locking
+// for the plugin process; empty/0/false/-1 use the module defaults
+// applied on the next plugin start
+void carla_priv_set_process_policy(struct carla_priv *carla, const char *cpus,
+				   int nice, bool realtime, int numaNode,
+				   bool lockMemory);
+
+// run one instance per channel if the plugin is mono, with linked parameters
+// `channels` is the number of OBS audio channels, 0 or 1 disables this
+void carla_priv_set_per_channel(struct carla_priv *carla, uint32_t channels);
+
+// named plugin state snapshots, stored in the source settings
+// the preloaded snapshot is kept running next to the current plugin, so that
+// recalling it only needs a short crossfade, other snapshots are started
+// first; an empty name preloads nothing
+// recall can be called from any thread, the switch happens during idle
+// returns false if there is no snapshot with this name
+void carla_priv_save_snapshot(struct carla_priv *carla, const char *name);
+void carla_priv_delete_snapshot(struct carla_priv *carla, const char *name);
+void carla_priv_preload_snapshot(struct carla_priv *carla, const char *name);
+bool carla_priv_recall_snapshot(struct carla_priv *carla, const char *name);
+#endif
+
 void carla_priv_readd_properties(struct carla_priv *carla,
 				 obs_properties_t *props, bool reset);
 
+// get current values of plugin output parameters (meters, readouts)
+// must be called from the same thread as `carla_priv_idle`
+// returns the number of values written, up to `maxCount`
+uint32_t carla_priv_get_output_params(struct carla_priv *carla,
+				      uint32_t *indices, float *values,
+				      uint32_t maxCount);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,7 @@
 
 #include <obs-module.h>
 #include <util/platform.h>
+#include <util/threading.h>
 
 #ifndef CARLA_MODULE_ID
 #error CARLA_MODULE_ID undefined
@@ -24,6 +25,29 @@
 // default mode, defined as macro for easy change
 #define DEFAULT_BUFFER_SIZE_MODE buffer_size_direct
 
+// default output parameter refresh rate, in Hz
+#define DEFAULT_OUTPUT_RATE 10
+
+// maximum number of output parameters exposed to other threads
+#define MAX_OUTPUT_PARAMS 64
+
+// --------------------------------------------------------------------------------------------------------------------
+
+// snapshot of plugin output parameter values, written by the tick thread
+// readers check the sequence counter (odd while writing) and retry on change,
+// all fields are accessed atomically so readers never need a lock
+struct carla_output_snapshot {
+	volatile long seq;
+	volatile long count;
+	volatile long indices[MAX_OUTPUT_PARAMS];
+	volatile long values[MAX_OUTPUT_PARAMS];
+};
+
+union carla_float_bits {
+	float f;
+	int32_t i;
+};
+
 // --------------------------------------------------------------------------------------------------------------------
 
 struct carla_data {
@@ -49,6 +73,16 @@ struct carla_data {
 
 	// dummy buffer for unused audio channels
 	float *dummybuffer;
+
+	// output parameter readout, rate in Hz, 0 means disabled
+	struct carla_output_snapshot outputs;
+	volatile long output_rate;
+	uint64_t output_last_update;
+
+#ifdef BUILDING_CARLA_OBS
+	// recalls the selected state snapshot
+	obs_hotkey_id snapshot_hotkey;
+#endif
 };
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -93,18 +127,169 @@ static void *carla_obs_audio_gen_thread(void *data)
 	return NULL;
 }
 
+static void carla_obs_update_outputs(struct carla_data *carla)
+{
+	const long rate = os_atomic_load_long(&carla->output_rate);
+	if (rate <= 0)
+		return;
+
+	const uint64_t now = os_gettime_ns();
+	if (now - carla->output_last_update < 1000000000ULL / rate)
+		return;
+
+	carla->output_last_update = now;
+
+	uint32_t indices[MAX_OUTPUT_PARAMS];
+	float values[MAX_OUTPUT_PARAMS];
+	const uint32_t count = carla_priv_get_output_params(
+		carla->priv, indices, values, MAX_OUTPUT_PARAMS);
+
+	struct carla_output_snapshot *snap = &carla->outputs;
+
+	// only this thread writes, the previous values can be read as-is
+	bool changed = os_atomic_load_long(&snap->count) != (long)count;
+
+	os_atomic_inc_long(&snap->seq);
+
+	os_atomic_set_long(&snap->count, count);
+	for (uint32_t i = 0; i < count; ++i) {
+		const union carla_float_bits bits = {.f = values[i]};
+		changed |= os_atomic_load_long(&snap->indices[i]) != indices[i];
+		changed |= os_atomic_load_long(&snap->values[i]) != bits.i;
+		os_atomic_set_long(&snap->indices[i], indices[i]);
+		os_atomic_set_long(&snap->values[i], bits.i);
+	}
+
+	os_atomic_inc_long(&snap->seq);
+
+	// the readout in the properties is static text, rebuild it at the
+	// same rate, the signal only reaches properties views that are open
+	if (changed) {
+		signal_handler_t *sighandler =
+			obs_source_get_signal_handler(carla->source);
+		signal_handler_signal(sighandler, "update_properties", NULL);
+	}
+}
+
+// read latest output parameter values, can be called from any thread
+static uint32_t carla_obs_read_outputs(struct carla_data *carla,
+				       uint32_t indices[MAX_OUTPUT_PARAMS],
+				       float values[MAX_OUTPUT_PARAMS])
+{
+	struct carla_output_snapshot *snap = &carla->outputs;
+
+	for (;;) {
+		const long seq = os_atomic_load_long(&snap->seq);
+
+		// writer in progress
+		if (seq & 1)
+			continue;
+
+		const uint32_t count = (uint32_t)os_atomic_load_long(&snap->count);
+		for (uint32_t i = 0; i < count; ++i) {
+			union carla_float_bits bits;
+			bits.i = (int32_t)os_atomic_load_long(&snap->values[i]);
+			indices[i] =
+				(uint32_t)os_atomic_load_long(&snap->indices[i]);
+			values[i] = bits.f;
+		}
+
+		if (os_atomic_load_long(&snap->seq) == seq)
+			return count;
+	}
+}
+
 static void carla_obs_idle_callback(void *data, float unused)
 {
 	UNUSED_PARAMETER(unused);
 	struct carla_data *carla = data;
 	carla_priv_idle(carla->priv);
+	carla_obs_update_outputs(carla);
 }
 
+static void carla_obs_get_output_parameter(void *data, calldata_t *cd)
+{
+	struct carla_data *carla = data;
+
+	const long long index = calldata_int(cd, "index");
+
+	uint32_t indices[MAX_OUTPUT_PARAMS];
+	float values[MAX_OUTPUT_PARAMS];
+	const uint32_t count = carla_obs_read_outputs(carla, indices, values);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if ((long long)indices[i] != index)
+			continue;
+
+		calldata_set_float(cd, "value", values[i]);
+		calldata_set_bool(cd, "found", true);
+		return;
+	}
+
+	calldata_set_float(cd, "value", 0.0);
+	calldata_set_bool(cd, "found", false);
+}
+
+static void carla_obs_get_output_parameters(void *data, calldata_t *cd)
+{
+	struct carla_data *carla = data;
+
+	uint32_t indices[MAX_OUTPUT_PARAMS];
+	float values[MAX_OUTPUT_PARAMS];
+	const uint32_t count = carla_obs_read_outputs(carla, indices, values);
+
+	// same keys as used for parameter settings
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+	obs_data_t *outputs = obs_data_create();
+
+	for (uint32_t i = 0; i < count; ++i) {
+		param_index_to_name(indices[i], pname);
+		obs_data_set_double(outputs, pname, values[i]);
+	}
+
+	calldata_set_string(cd, "json", obs_data_get_json(outputs));
+	obs_data_release(outputs);
+}
+
+#ifdef BUILDING_CARLA_OBS
+static void carla_obs_recall_snapshot(void *data, calldata_t *cd)
+{
+	struct carla_data *carla = data;
+
+	const char *name = calldata_string(cd, "name");
+
+	calldata_set_bool(cd, "found",
+			  carla_priv_recall_snapshot(carla->priv, name));
+}
+
+static void carla_obs_recall_snapshot_hotkey(void *data, obs_hotkey_id id,
+					     obs_hotkey_t *hotkey,
+					     bool pressed)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(hotkey);
+
+	struct carla_data *carla = data;
+
+	if (!pressed)
+		return;
+
+	obs_data_t *settings = obs_source_get_settings(carla->source);
+	carla_priv_recall_snapshot(
+		carla->priv, obs_data_get_string(settings, PROP_SNAPSHOT));
+	obs_data_release(settings);
+}
+#endif
+
 // --------------------------------------------------------------------------------------------------------------------
 // obs plugin methods
 
 static void carla_obs_activate(void *data);
 static void carla_obs_deactivate(void *data);
+#ifdef BUILDING_CARLA_OBS
+static void carla_obs_update_process_policy(struct carla_data *carla,
+					    obs_data_t *settings);
+#endif
 
 static const char *carla_obs_get_name(void *data)
 {
@@ -116,8 +301,6 @@ static const char *carla_obs_get_name(void *data)
 static void *carla_obs_create(obs_data_t *settings, obs_source_t *source,
 			      bool isFilter)
 {
-	UNUSED_PARAMETER(settings);
-
 	const audio_t *audio = obs_get_audio();
 	const size_t channels = audio_output_get_channels(audio);
 	const uint32_t sample_rate = audio_output_get_sample_rate(audio);
@@ -157,6 +340,40 @@ static void *carla_obs_create(obs_data_t *settings, obs_source_t *source,
 	// audio generator, aka input source
 	carla->audiogen_enabled = !isFilter;
 
+	carla->output_rate = (long)obs_data_get_int(settings, PROP_OUTPUT_RATE);
+
+#ifdef BUILDING_CARLA_OBS
+	if (obs_data_get_bool(settings, PROP_PIPELINED))
+		carla_priv_set_pipelined(priv, true);
+
+	carla_obs_update_process_policy(carla, settings);
+
+	if (obs_data_get_bool(settings, PROP_PER_CHANNEL))
+		carla_priv_set_per_channel(priv, (uint32_t)channels);
+#endif
+
+	proc_handler_t *ph = obs_source_get_proc_handler(source);
+	proc_handler_add(
+		ph,
+		"void get_output_parameter(in int index, out float value, out bool found)",
+		carla_obs_get_output_parameter, carla);
+	proc_handler_add(ph, "void get_output_parameters(out string json)",
+			 carla_obs_get_output_parameters, carla);
+
+#ifdef BUILDING_CARLA_OBS
+	proc_handler_add(ph,
+			 "void recall_snapshot(in string name, out bool found)",
+			 carla_obs_recall_snapshot, carla);
+
+	carla->snapshot_hotkey = obs_hotkey_register_source(
+		source, CARLA_MODULE_ID ".recall-snapshot",
+		obs_module_text("Recall selected snapshot"),
+		carla_obs_recall_snapshot_hotkey, carla);
+
+	carla_priv_preload_snapshot(
+		priv, obs_data_get_string(settings, PROP_SNAPSHOT));
+#endif
+
 	obs_add_tick_callback(carla_obs_idle_callback, carla);
 
 	return carla;
@@ -243,6 +460,193 @@ static bool carla_obs_bufsize_callback(void *data, obs_properties_t *props,
 	return false;
 }
 
+#ifdef BUILDING_CARLA_OBS
+static bool carla_obs_pipelined_callback(void *data, obs_properties_t *props,
+					 obs_property_t *property,
+					 obs_data_t *settings)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+
+	struct carla_data *carla = data;
+
+	carla_priv_set_pipelined(carla->priv,
+				 obs_data_get_bool(settings, PROP_PIPELINED));
+
+	return false;
+}
+
+static bool carla_obs_per_channel_callback(void *data,
+					   obs_properties_t *props,
+					   obs_property_t *property,
+					   obs_data_t *settings)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+
+	struct carla_data *carla = data;
+
+	carla_priv_set_per_channel(
+		carla->priv, obs_data_get_bool(settings, PROP_PER_CHANNEL)
+				     ? (uint32_t)carla->channels
+				     : 0);
+
+	return false;
+}
+
+static void carla_obs_update_process_policy(struct carla_data *carla,
+					    obs_data_t *settings)
+{
+	carla_priv_set_process_policy(
+		carla->priv, obs_data_get_string(settings, PROP_BRIDGE_CPUS),
+		(int)obs_data_get_int(settings, PROP_BRIDGE_NICE),
+		obs_data_get_bool(settings, PROP_BRIDGE_REALTIME),
+		(int)obs_data_get_int(settings, PROP_BRIDGE_NUMA_NODE),
+		obs_data_get_bool(settings, PROP_BRIDGE_LOCK_MEMORY));
+}
+
+static bool carla_obs_process_policy_callback(void *data,
+					      obs_properties_t *props,
+					      obs_property_t *property,
+					      obs_data_t *settings)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+
+	struct carla_data *carla = data;
+
+	carla_obs_update_process_policy(carla, settings);
+
+	return false;
+}
+#endif
+
+static bool carla_obs_output_rate_callback(void *data,
+					   obs_properties_t *props,
+					   obs_property_t *list,
+					   obs_data_t *settings)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(list);
+
+	struct carla_data *carla = data;
+
+	os_atomic_set_long(&carla->output_rate,
+			   (long)obs_data_get_int(settings, PROP_OUTPUT_RATE));
+
+	return false;
+}
+
+#ifdef BUILDING_CARLA_OBS
+static void carla_obs_fill_snapshot_list(struct carla_data *carla,
+					 obs_property_t *list)
+{
+	obs_property_list_clear(list);
+	obs_property_list_add_string(list, obs_module_text("None"), "");
+
+	obs_data_t *settings = obs_source_get_settings(carla->source);
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_SNAPSHOTS);
+
+	for (size_t i = 0, count = obs_data_array_count(array); i < count;
+	     ++i) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		const char *name = obs_data_get_string(item, "name");
+		obs_property_list_add_string(list, name, name);
+		obs_data_release(item);
+	}
+
+	obs_data_array_release(array);
+	obs_data_release(settings);
+}
+
+static bool carla_obs_snapshot_callback(void *data, obs_properties_t *props,
+					obs_property_t *list,
+					obs_data_t *settings)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(list);
+
+	struct carla_data *carla = data;
+
+	// keep the selected snapshot ready for recall
+	carla_priv_preload_snapshot(
+		carla->priv, obs_data_get_string(settings, PROP_SNAPSHOT));
+
+	return false;
+}
+
+static bool carla_obs_save_snapshot_callback(obs_properties_t *props,
+					     obs_property_t *property,
+					     void *data)
+{
+	UNUSED_PARAMETER(property);
+
+	struct carla_data *carla = data;
+
+	obs_data_t *settings = obs_source_get_settings(carla->source);
+	const char *name = obs_data_get_string(settings, PROP_SNAPSHOT_NAME);
+
+	if (name[0] != '\0') {
+		carla_priv_save_snapshot(carla->priv, name);
+		obs_data_set_string(settings, PROP_SNAPSHOT, name);
+		carla_priv_preload_snapshot(carla->priv, name);
+		carla_obs_fill_snapshot_list(
+			carla, obs_properties_get(props, PROP_SNAPSHOT));
+	}
+
+	obs_data_release(settings);
+	return true;
+}
+
+static bool carla_obs_recall_snapshot_callback(obs_properties_t *props,
+					       obs_property_t *property,
+					       void *data)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+
+	struct carla_data *carla = data;
+
+	obs_data_t *settings = obs_source_get_settings(carla->source);
+	carla_priv_recall_snapshot(
+		carla->priv, obs_data_get_string(settings, PROP_SNAPSHOT));
+	obs_data_release(settings);
+
+	// properties are updated once the switch is done
+	return false;
+}
+
+static bool carla_obs_delete_snapshot_callback(obs_properties_t *props,
+					       obs_property_t *property,
+					       void *data)
+{
+	UNUSED_PARAMETER(property);
+
+	struct carla_data *carla = data;
+
+	obs_data_t *settings = obs_source_get_settings(carla->source);
+
+	carla_priv_delete_snapshot(
+		carla->priv, obs_data_get_string(settings, PROP_SNAPSHOT));
+	obs_data_set_string(settings, PROP_SNAPSHOT, "");
+	carla_priv_preload_snapshot(carla->priv, "");
+	carla_obs_fill_snapshot_list(carla,
+				     obs_properties_get(props, PROP_SNAPSHOT));
+
+	obs_data_release(settings);
+	return true;
+}
+#endif
+
+static void carla_obs_get_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, PROP_OUTPUT_RATE,
+				 DEFAULT_OUTPUT_RATE);
+#ifdef BUILDING_CARLA_OBS
+	obs_data_set_default_int(settings, PROP_BRIDGE_NUMA_NODE, -1);
+#endif
+}
+
 static obs_properties_t *carla_obs_get_properties(void *data)
 {
 	struct carla_data *carla = data;
@@ -270,6 +674,107 @@ static obs_properties_t *carla_obs_get_properties(void *data)
 	obs_property_set_modified_callback2(list, carla_obs_bufsize_callback,
 					    carla);
 
+#ifdef BUILDING_CARLA_OBS
+	// bridge module only, its plugins run in separate processes
+	obs_property_t *pipelined = obs_properties_add_bool(
+		props, PROP_PIPELINED,
+		obs_module_text("Pipelined processing (adds latency)"));
+	obs_property_set_modified_callback2(
+		pipelined, carla_obs_pipelined_callback, carla);
+
+	// only read on load, nothing to do when changed
+	obs_properties_add_bool(
+		props, PROP_LAZY_START,
+		obs_module_text("Start plugin on first use (when loading)"));
+
+	obs_property_t *per_channel = obs_properties_add_bool(
+		props, PROP_PER_CHANNEL,
+		obs_module_text("Run mono plugins once per channel"));
+	obs_property_set_modified_callback2(
+		per_channel, carla_obs_per_channel_callback, carla);
+
+	// process policy, used from the next plugin start
+	// only what the platform can apply is shown
+	obs_property_t *prop;
+
+#ifndef __APPLE__
+	prop = obs_properties_add_text(
+		props, PROP_BRIDGE_CPUS,
+		obs_module_text("Plugin process CPUs (e.g. 2,3 or 4-7)"),
+		OBS_TEXT_DEFAULT);
+	obs_property_set_modified_callback2(
+		prop, carla_obs_process_policy_callback, carla);
+#endif
+
+	prop = obs_properties_add_int(props, PROP_BRIDGE_NICE,
+				      obs_module_text("Plugin process nice level"),
+				      -20, 19, 1);
+	obs_property_set_modified_callback2(
+		prop, carla_obs_process_policy_callback, carla);
+
+#ifdef __linux__
+	// elsewhere the bridge can raise its audio thread priority anyway
+	prop = obs_properties_add_bool(
+		props, PROP_BRIDGE_REALTIME,
+		obs_module_text("Allow realtime priority for plugin audio"));
+	obs_property_set_modified_callback2(
+		prop, carla_obs_process_policy_callback, carla);
+
+	prop = obs_properties_add_int(
+		props, PROP_BRIDGE_NUMA_NODE,
+		obs_module_text("Plugin process NUMA node (-1 for any)"), -1,
+		63, 1);
+	obs_property_set_modified_callback2(
+		prop, carla_obs_process_policy_callback, carla);
+#endif
+
+	prop = obs_properties_add_bool(
+		props, PROP_BRIDGE_LOCK_MEMORY,
+		obs_module_text("Lock plugin audio memory in RAM"));
+	obs_property_set_modified_callback2(
+		prop, carla_obs_process_policy_callback, carla);
+#endif
+
+	list = obs_properties_add_list(props, PROP_OUTPUT_RATE,
+				       obs_module_text("Output Refresh Rate"),
+				       OBS_COMBO_TYPE_LIST,
+				       OBS_COMBO_FORMAT_INT);
+
+	obs_property_list_add_int(list, obs_module_text("Disabled"), 0);
+	obs_property_list_add_int(list, obs_module_text("1 Hz"), 1);
+	obs_property_list_add_int(list, obs_module_text("10 Hz"), 10);
+	obs_property_list_add_int(list, obs_module_text("30 Hz"), 30);
+	obs_property_list_add_int(list, obs_module_text("60 Hz"), 60);
+	obs_property_set_modified_callback2(
+		list, carla_obs_output_rate_callback, carla);
+
+#ifdef BUILDING_CARLA_OBS
+	// state snapshots, the selected one is kept ready for recall
+	obs_properties_add_text(props, PROP_SNAPSHOT_NAME,
+				obs_module_text("Snapshot name"),
+				OBS_TEXT_DEFAULT);
+
+	obs_properties_add_button2(props, PROP_SAVE_SNAPSHOT,
+				   obs_module_text("Save snapshot"),
+				   carla_obs_save_snapshot_callback, carla);
+
+	list = obs_properties_add_list(props, PROP_SNAPSHOT,
+				       obs_module_text("Snapshot"),
+				       OBS_COMBO_TYPE_LIST,
+				       OBS_COMBO_FORMAT_STRING);
+	carla_obs_fill_snapshot_list(carla, list);
+	obs_property_set_modified_callback2(list, carla_obs_snapshot_callback,
+					    carla);
+
+	obs_properties_add_button2(props, PROP_RECALL_SNAPSHOT,
+				   obs_module_text("Recall snapshot"),
+				   carla_obs_recall_snapshot_callback, carla);
+
+	obs_properties_add_button2(props, PROP_DELETE_SNAPSHOT,
+				   obs_module_text("Delete snapshot"),
+				   carla_obs_delete_snapshot_callback, carla);
+#endif
+
 	carla_priv_readd_properties(carla->priv, props, false);
 
 	return props;
@@ -313,6 +818,12 @@ static void carla_obs_deactivate(void *data)
 	carla_priv_deactivate(carla->priv);
 }
 
+static void carla_obs_show(void *data)
+{
+	struct carla_data *carla = data;
+	carla_priv_show(carla->priv);
+}
+
 static void carla_obs_filter_audio_direct(struct carla_data *carla,
 					  struct obs_audio_data *audio)
 {
@@ -474,12 +985,14 @@ bool obs_module_load(void)
 		.get_name = carla_obs_get_name,
 		.create = carla_obs_create_filter,
 		.destroy = carla_obs_destroy,
-		// get_width, get_height, get_defaults
+		// get_width, get_height
+		.get_defaults = carla_obs_get_defaults,
 		.get_properties = carla_obs_get_properties,
 		// update
 		.activate = carla_obs_activate,
 		.deactivate = carla_obs_deactivate,
-		// show, hide, video_tick, video_render, filter_video
+		.show = carla_obs_show,
+		// hide, video_tick, video_render, filter_video
 		.filter_audio = carla_obs_filter_audio,
 		// enum_active_sources
 		.save = carla_obs_save,
@@ -502,12 +1015,14 @@ bool obs_module_load(void)
 		.get_name = carla_obs_get_name,
 		.create = carla_obs_create_input,
 		.destroy = carla_obs_destroy,
-		// get_width, get_height, get_defaults
+		// get_width, get_height
+		.get_defaults = carla_obs_get_defaults,
 		.get_properties = carla_obs_get_properties,
 		// update
 		.activate = carla_obs_activate,
 		.deactivate = carla_obs_deactivate,
-		// show, hide, video_tick, video_render, filter_video, filter_audio, enum_active_sources
+		.show = carla_obs_show,
+		// hide, video_tick, video_render, filter_video, filter_audio, enum_active_sources
 		.save = carla_obs_save,
 		.load = carla_obs_load,
 		// mouse_click, mouse_move, mouse_wheel, focus, key_click, filter_remove,
@@ -521,6 +1036,8 @@ bool obs_module_load(void)
 	};
 	obs_register_source(&input);
 
+	carla_priv_module_load();
+
 	return true;
 }
 
@@ -10,8 +10,10 @@
 #endif
 
 #include "common.h"
+#include "carla-wrapper.h"
 
 #include <obs-module.h>
+#include <util/darray.h>
 #include <util/platform.h>
 
 #ifdef _WIN32
@@ -168,30 +170,120 @@ const char *get_carla_resource_path(void)
 
 void param_index_to_name(uint32_t index, char name[PARAM_NAME_SIZE])
 {
-	name[1] = '0' + ((index / 100) % 10);
-	name[2] = '0' + ((index / 10) % 10);
-	name[3] = '0' + ((index / 1) % 10);
+	snprintf(name, PARAM_NAME_SIZE, "p%03u", index);
 }
 
-void remove_all_props(obs_properties_t *props, obs_data_t *settings)
+bool is_param_name(const char *name)
 {
-	obs_data_erase(settings, PROP_SHOW_GUI);
-	obs_properties_remove_by_name(props, PROP_SHOW_GUI);
+	if (name[0] != 'p' || name[1] == '\0')
+		return false;
 
-	obs_data_erase(settings, PROP_CHUNK);
-	obs_properties_remove_by_name(props, PROP_CHUNK);
+	for (const char *c = name + 1; *c != '\0'; ++c) {
+		if (*c < '0' || *c > '9')
+			return false;
+	}
 
-	obs_data_erase(settings, PROP_CUSTOM_DATA);
-	obs_properties_remove_by_name(props, PROP_CUSTOM_DATA);
+	return true;
+}
 
-	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+void remove_param_props(obs_properties_t *props)
+{
+	// collect names first, cannot remove properties while iterating
+	DARRAY(const char *) names;
+	da_init(names);
+
+	obs_property_t *prop = obs_properties_first(props);
+
+	while (prop != NULL) {
+		const char *name = obs_property_name(prop);
+		if (is_param_name(name)) {
+			const char *copy = bstrdup(name);
+			da_push_back(names, &copy);
+		}
+		obs_property_next(&prop);
+	}
+
+	for (size_t i = 0; i < names.num; ++i) {
+		obs_properties_remove_by_name(props, names.array[i]);
+		bfree((void *)names.array[i]);
+	}
+
+	da_free(names);
+}
+
+bool remove_param_settings(obs_data_t *settings, uint32_t firstIndex)
+{
+	// collect names first, cannot remove items while iterating
+	DARRAY(const char *) names;
+	da_init(names);
+
+	obs_data_item_t *item = obs_data_first(settings);
+
+	while (item != NULL) {
+		const char *name = obs_data_item_get_name(item);
+		if (is_param_name(name) &&
+		    strtoul(name + 1, NULL, 10) >= firstIndex) {
+			const char *copy = bstrdup(name);
+			da_push_back(names, &copy);
+		}
+		obs_data_item_next(&item);
+	}
+
+	for (size_t i = 0; i < names.num; ++i) {
+		obs_data_erase(settings, names.array[i]);
+		obs_data_unset_default_value(settings, names.array[i]);
+		bfree((void *)names.array[i]);
+	}
 
-	for (uint32_t i = 0; i < MAX_PARAMS; ++i) {
-		param_index_to_name(i, pname);
-		obs_data_erase(settings, pname);
-		obs_data_unset_default_value(settings, pname);
-		obs_properties_remove_by_name(props, pname);
+	const bool removed = names.num != 0;
+	da_free(names);
+	return removed;
+}
+
+uint32_t get_param_page_count(uint32_t paramCount)
+{
+	return (paramCount + PARAMS_PER_PAGE - 1) / PARAMS_PER_PAGE;
+}
+
+void add_param_page_list(obs_properties_t *props, uint32_t paramCount,
+			 obs_property_modified2_t callback, void *priv)
+{
+	const uint32_t pages = get_param_page_count(paramCount);
+
+	if (pages <= 1)
+		return;
+
+	obs_property_t *list = obs_properties_add_list(
+		props, PROP_PARAM_PAGE, obs_module_text("Parameters"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+
+	char name[32];
+
+	for (uint32_t i = 0; i < pages; ++i) {
+		const uint32_t first = i * PARAMS_PER_PAGE;
+		const uint32_t last = i + 1 == pages
+					      ? paramCount
+					      : first + PARAMS_PER_PAGE;
+		snprintf(name, sizeof(name), "%u - %u", first + 1, last);
+		obs_property_list_add_int(list, name, i);
 	}
+
+	obs_property_set_modified_callback2(list, callback, priv);
+}
+
+void add_output_param_prop(obs_properties_t *props, uint32_t index,
+			   const char *name, float value, const char *unit)
+{
+	char pname[PARAM_NAME_SIZE] = PARAM_NAME_INIT;
+	param_index_to_name(index, pname);
+
+	char text[256];
+	if (unit != NULL && *unit != '\0')
+		snprintf(text, sizeof(text), "%s: %.2f %s", name, value, unit);
+	else
+		snprintf(text, sizeof(text), "%s: %.2f", name, value);
+
+	obs_properties_add_text(props, pname, text, OBS_TEXT_INFO);
 }
 
 void postpone_update_request(uint64_t *update_req)
@@ -226,6 +318,8 @@ void handle_update_request(obs_source_t *source, uint64_t *update_req)
 
 void obs_module_unload(void)
 {
+	carla_priv_module_unload();
+
 	bfree(module_path);
 	module_path = NULL;
 }
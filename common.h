@@ -8,9 +8,11 @@
 
 #include <obs-module.h>
 
-#define MAX_PARAMS 100
+// parameters are shown in pages of this size
+#define PARAMS_PER_PAGE 100
 
-#define PARAM_NAME_SIZE 5
+// "p" + up to 10 digits, at least 3 digits are always used
+#define PARAM_NAME_SIZE 12
 #define PARAM_NAME_INIT                  \
 	{                                \
 		'p', '0', '0', '0', '\0' \
@@ -21,10 +23,26 @@
 #define PROP_SELECT_PLUGIN "select-plugin"
 #define PROP_RELOAD_PLUGIN "reload"
 #define PROP_BUFFER_SIZE "buffer-size"
+#define PROP_PIPELINED "pipelined"
+#define PROP_LAZY_START "lazy-start"
+#define PROP_PER_CHANNEL "per-channel"
+#define PROP_BRIDGE_CPUS "bridge-cpus"
+#define PROP_BRIDGE_NICE "bridge-nice"
+#define PROP_BRIDGE_REALTIME "bridge-realtime"
+#define PROP_BRIDGE_NUMA_NODE "bridge-numa-node"
+#define PROP_BRIDGE_LOCK_MEMORY "bridge-lock-memory"
 #define PROP_SHOW_GUI "show-gui"
+#define PROP_PARAM_PAGE "param-page"
+#define PROP_OUTPUT_RATE "output-rate"
+#define PROP_SNAPSHOT "snapshot"
+#define PROP_SNAPSHOT_NAME "snapshot-name"
+#define PROP_SAVE_SNAPSHOT "save-snapshot"
+#define PROP_RECALL_SNAPSHOT "recall-snapshot"
+#define PROP_DELETE_SNAPSHOT "delete-snapshot"
 
 #define PROP_CHUNK "chunk"
 #define PROP_CUSTOM_DATA "customdata"
+#define PROP_SNAPSHOTS "snapshots"
 
 // ----------------------------------------------------------------------------
 
@@ -36,7 +54,22 @@ const char *get_carla_bin_path(void);
 const char *get_carla_resource_path(void);
 
 void param_index_to_name(uint32_t index, char name[PARAM_NAME_SIZE]);
-void remove_all_props(obs_properties_t *props, obs_data_t *settings);
+bool is_param_name(const char *name);
+
+void remove_param_props(obs_properties_t *props);
+
+// remove values and defaults of parameters starting at `firstIndex`
+// returns true if any parameter setting was removed
+bool remove_param_settings(obs_data_t *settings, uint32_t firstIndex);
+
+// parameter pages, the page list is only added when there is more than one
+uint32_t get_param_page_count(uint32_t paramCount);
+void add_param_page_list(obs_properties_t *props, uint32_t paramCount,
+			 obs_property_modified2_t callback, void *priv);
+
+// read-only text showing the current value of a plugin output parameter
+void add_output_param_prop(obs_properties_t *props, uint32_t index,
+			   const char *name, float value, const char *unit);
 
 void postpone_update_request(uint64_t *update_req);
 void handle_update_request(obs_source_t *source, uint64_t *update_req);
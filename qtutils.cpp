@@ -6,23 +6,173 @@
 
 #include "qtutils.h"
 
-#include <QtCore/QTimer>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
 
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+// main thread dispatch queue, one per module
+// bounded multi-producer single-consumer queue, based on Dmitry Vyukov's
+// sequence-numbered ring, drained on the main thread by a single posted event
+
+#define MAIN_THREAD_QUEUE_SIZE 1024 // must be power of 2
+
+struct main_thread_message {
+	void (*callback)(void *param);
+	void *param;
+	bool copied;
+	alignas(std::max_align_t) unsigned char data[CARLA_QT_CALLBACK_DATA_SIZE];
+};
+
+struct main_thread_cell {
+	std::atomic<size_t> sequence;
+	main_thread_message message;
+};
+
+static struct main_thread_queue {
+	main_thread_cell cells[MAIN_THREAD_QUEUE_SIZE];
+	alignas(64) std::atomic<size_t> enqueuePos{0};
+	alignas(64) size_t dequeuePos = 0;
+	std::atomic<bool> drainPending{false};
+
+	main_thread_queue()
+	{
+		for (size_t i = 0; i < MAIN_THREAD_QUEUE_SIZE; ++i)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool push(const main_thread_message &message)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		main_thread_cell *cell;
+
+		for (;;) {
+			cell = &cells[pos & (MAIN_THREAD_QUEUE_SIZE - 1)];
+			const size_t seq =
+				cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+			if (diff == 0) {
+				if (enqueuePos.compare_exchange_weak(
+					    pos, pos + 1,
+					    std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				// full
+				return false;
+			} else {
+				pos = enqueuePos.load(
+					std::memory_order_relaxed);
+			}
+		}
+
+		cell->message = message;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// main thread only
+	bool pop(main_thread_message &message)
+	{
+		main_thread_cell *cell =
+			&cells[dequeuePos & (MAIN_THREAD_QUEUE_SIZE - 1)];
+		const size_t seq = cell->sequence.load(std::memory_order_acquire);
+
+		if ((intptr_t)seq - (intptr_t)(dequeuePos + 1) < 0)
+			return false;
+
+		message = cell->message;
+		cell->sequence.store(dequeuePos + MAIN_THREAD_QUEUE_SIZE,
+				     std::memory_order_release);
+		++dequeuePos;
+		return true;
+	}
+} s_main_thread_queue;
+
+static void run_main_thread_message(main_thread_message &message)
+{
+	message.callback(message.copied ? message.data : message.param);
+}
+
+static void post_main_thread_drain();
+
+static void drain_main_thread_queue()
+{
+	main_thread_queue &queue(s_main_thread_queue);
+
+	// reset before reading, so messages pushed from now on post a new drain
+	queue.drainPending.store(false);
+
+	main_thread_message message;
+
+	// limit work per event so a busy producer cannot block the UI
+	for (size_t i = 0; i < MAIN_THREAD_QUEUE_SIZE; ++i) {
+		if (!queue.pop(message))
+			return;
+		run_main_thread_message(message);
+	}
+
+	if (!queue.drainPending.exchange(true))
+		post_main_thread_drain();
+}
+
+static void post_main_thread_drain()
+{
+	QMetaObject::invokeMethod(qApp, drain_main_thread_queue,
+				  Qt::QueuedConnection);
+}
+
+static void push_main_thread_message(const main_thread_message &message)
+{
+	main_thread_queue &queue(s_main_thread_queue);
+
+	if (!queue.push(message)) {
+		// queue is full, fallback to a dedicated event for this message
+		QMetaObject::invokeMethod(
+			qApp,
+			[message]() mutable {
+				run_main_thread_message(message);
+			},
+			Qt::QueuedConnection);
+		return;
+	}
+
+	// only the push that makes the queue non-empty needs to post an event
+	if (!queue.drainPending.exchange(true))
+		post_main_thread_drain();
+}
+
+// ----------------------------------------------------------------------------
+
 void carla_qt_callback_on_main_thread(void (*callback)(void *param),
 				      void *param)
 {
-	QTimer *const maintimer = new QTimer;
-	maintimer->moveToThread(qApp->thread());
-	maintimer->setSingleShot(true);
-	QObject::connect(maintimer, &QTimer::timeout,
-			 [maintimer, callback, param]() {
-				 callback(param);
-				 maintimer->deleteLater();
-			 });
-	QMetaObject::invokeMethod(maintimer, "start", Qt::QueuedConnection,
-				  Q_ARG(int, 0));
+	main_thread_message message;
+	message.callback = callback;
+	message.param = param;
+	message.copied = false;
+
+	push_main_thread_message(message);
+}
+
+void carla_qt_callback_on_main_thread_copy(void (*callback)(void *param),
+					   const void *data, size_t size)
+{
+	assert(size <= CARLA_QT_CALLBACK_DATA_SIZE);
+	if (size > CARLA_QT_CALLBACK_DATA_SIZE)
+		return;
+
+	main_thread_message message;
+	message.callback = callback;
+	message.param = nullptr;
+	message.copied = true;
+	std::memcpy(message.data, data, size);
+
+	push_main_thread_message(message);
 }
 
 const char *carla_qt_file_dialog(bool save, bool isDir, const char *title,
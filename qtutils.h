@@ -7,17 +7,27 @@
 #pragma once
 
 #ifdef __cplusplus
+#include <cstddef>
 #include <cstdint>
 #include <QtWidgets/QMainWindow>
 extern "C" {
 #else
+#include <stddef.h>
 #include <stdint.h>
 typedef struct QMainWindow QMainWindow;
 #endif
 
+// maximum data size for carla_qt_callback_on_main_thread_copy
+#define CARLA_QT_CALLBACK_DATA_SIZE 64
+
 void carla_qt_callback_on_main_thread(void (*callback)(void *param),
 				      void *param);
 
+// same as above, but `data` is copied into a pre-allocated queue slot
+// callback receives a pointer to the copy, valid only during the call
+void carla_qt_callback_on_main_thread_copy(void (*callback)(void *param),
+					   const void *data, size_t size);
+
 const char *carla_qt_file_dialog(bool save, bool isDir, const char *title,
 				 const char *filter);
 